@@ -4,6 +4,9 @@
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
+#include "common/event_bus.hpp"
+#include "common/log_sampler.hpp"
 #include "common/message_queue.hpp"
 #include "network/network_model_manager.hpp"
 
@@ -18,8 +21,8 @@ public:
     X30InspectionSystem();
     ~X30InspectionSystem();
 
-    // 系统初始化和清理
-    bool initialize(const std::string& host, uint16_t port);
+    // 系统初始化和清理, capture_path非空时将收发的原始帧抓包到该文件
+    bool initialize(const std::string& host, uint16_t port, const std::string& capture_path = "");
 
     // 状态查询
     bool isConnected() const;
@@ -27,7 +30,7 @@ public:
     // 处理用户输入的指令
     void handleCommand(const std::string& command);
 
-    // 析构清理资源
+    // 按固定顺序停止各线程并释放资源, 可重复调用
     void shutdown();
 
 private:
@@ -39,26 +42,46 @@ private:
     // 重置 nav_state_procedure_
     void resetNavProcedure();
 
+    // 网络重连后恢复 nav_state_procedure_, 在重连线程中调用
+    void resumeNavProcedure();
+
     // 错误回调，目前即打印
     void handleError(const std::string& error) const;
 
     // 消息处理循环
     void messageProcessingLoop();
+    // 处理单条消息
+    void processMessage(const protocol::IMessage& message);
 
     // 打印日志
-    void printLog(const protocol::QueryStatusResponse& resp) const;
-    void printLog(const protocol::GetRealTimeStatusResponse& resp) const;
+    void printLog(const protocol::QueryStatusResponse& resp);
+    void printLog(const protocol::GetRealTimeStatusResponse& resp);
+
+    // 遥测日志采样, 仅在消息处理线程中使用; 每个实例对应一台机器人
+    common::LogRateLimiter real_time_log_limiter_{"2002实时状态", 0.2, 1};  // 每5秒最多一条
+    common::LogRateLimiter status_log_limiter_{"2007状态查询", 0.1, 1};     // 持续相同状态每10秒最多一条
+    common::ChangeFilter<int> location_filter_;
+    common::ChangeFilter<int> point_filter_;
+    common::ChangeFilter<protocol::NavigationStatus> status_filter_;
 
     // 消息队列
     common::MessageQueue message_queue_;
     std::atomic<bool> message_queue_running_{false};
     std::thread message_thread_;
 
+    // 遥测事件对象, 仅在消息处理线程中原地复用, 避免每次发布都拷贝分配timestamp
+    common::GetRealTimeStatusEvent real_time_status_event_;
+    common::QueryStatusEvent query_status_event_;
+
     // 网络通信接口
     std::unique_ptr<network::NetworkModelManager> network_model_manager_;
 
-    // 业务核心
+    // 业务核心, 只在消息处理线程中访问(启动前和shutdown中线程退出后除外)
     std::unique_ptr<procedure::BaseProcedure> nav_state_procedure_;
+
+    // initialize中订阅的事件, shutdown时取消
+    std::vector<common::EventBus::HandlerId> event_handler_ids_;
+    std::atomic<bool> shutdown_done_{false};
 };
 
 }  // namespace application
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <spdlog/sinks/sink.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/event_count.hpp"
+#include "common/mpsc_ring.hpp"
+
+namespace common {
+
+// 异步日志队列满时的处理策略
+enum class AsyncLogOverflowPolicy {
+    DROP_NEWEST,  // 丢弃新日志并计数, 调用线程不阻塞; 队列尾部预留给error及以上级别, 预留也用完时同样丢弃
+    BLOCK,        // 等待写线程腾出空间, 不丢日志
+};
+
+// 异步日志sink
+// 调用线程只把已格式化的消息正文拷贝进预分配的无锁环形队列后返回,
+// 时间格式化以及控制台, 文件I/O都由后台写线程转交给下游sink完成, 慢终端或慢磁盘不会阻塞网络和消息处理线程
+// error及以上级别的日志写出后立即flush下游sink; 正文超过PAYLOAD_CAPACITY字节时按UTF-8字符边界截断, 并以"…[truncated]"结尾
+class AsyncLogSink : public spdlog::sinks::sink {
+public:
+    static constexpr size_t PAYLOAD_CAPACITY = 448;
+    static constexpr size_t LOGGER_NAME_CAPACITY = 16;
+
+    AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t queue_capacity, AsyncLogOverflowPolicy overflow_policy);
+    ~AsyncLogSink() override;
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    void log(const spdlog::details::log_msg& msg) override;
+    // 阻塞直到调用前提交的日志全部写出, 并flush下游sink
+    void flush() override;
+    void set_pattern(const std::string& pattern) override;
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
+    uint64_t dropped() const;
+
+private:
+    struct Record {
+        spdlog::log_clock::time_point time;
+        spdlog::source_loc source;
+        size_t thread_id = 0;
+        spdlog::level::level_enum level = spdlog::level::info;
+        uint8_t logger_name_size = 0;
+        uint16_t payload_size = 0;
+        char logger_name[LOGGER_NAME_CAPACITY];
+        char payload[PAYLOAD_CAPACITY];
+    };
+
+    void writerLoop();
+    void write(const Record& record);
+    void reportDropped();
+
+    std::vector<spdlog::sink_ptr> sinks_;
+    const AsyncLogOverflowPolicy overflow_policy_;
+    MpscRing<Record> queue_;
+    const size_t normal_limit_;  // DROP_NEWEST下error以下级别可占用的槽位数, 其余预留给error及以上级别
+    EventCount not_empty_;
+    EventCount not_full_;
+    EventCount written_event_;  // 写线程每写完一批通知一次, 供flush等待
+
+    std::atomic<bool> running_{true};
+    std::atomic<uint64_t> written_{0};  // 写线程累计取出的记录数
+    std::atomic<uint64_t> dropped_{0};
+    uint64_t reported_dropped_ = 0;  // 仅写线程访问
+    std::thread writer_thread_;
+};
+
+}  // namespace common
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <spdlog/common.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace common {
+
+// 二进制日志文件格式:
+// 文件头(BinaryLogFileHeader) + 若干条记录(BinaryLogRecordHeader + 内容), type为0表示结束
+// FORMAT记录: 调用点首次使用时写入一次, 内容为 级别(1) + 行号(4) + 参数类型串(1+n) + 文件名(2+n) + 格式串(2+n)
+// ENTRY记录: 一次日志调用, 内容为按参数类型串依次排列的参数原始字节, 字符串为长度(2) + 字节
+// 参数类型: i int32, l int64, u uint32, U uint64, d double, b bool, s 字符串; 枚举按其底层整数类型记录
+#pragma pack(push, 1)
+struct BinaryLogFileHeader {
+    char magic[8];           // "X30BLG01"
+    uint64_t start_wall_ns;  // 开始记录时的系统时间, 纳秒
+    uint32_t version;        // 格式版本
+    uint32_t reserved;
+};
+
+struct BinaryLogRecordHeader {
+    uint8_t type;           // BinaryLogRecordType
+    uint16_t format_id;     // 调用点id, 从1开始
+    uint16_t length;        // 内容长度
+    uint64_t timestamp_ns;  // 相对开始记录时的单调时间, 纳秒; FORMAT记录为0
+};
+#pragma pack(pop)
+
+enum class BinaryLogRecordType : uint8_t {
+    END = 0,
+    FORMAT = 1,
+    ENTRY = 2,
+};
+
+// 调用点描述, 由X30_BLOG宏为每个调用点生成一个静态实例
+struct BinaryLogSite {
+    spdlog::level::level_enum level;
+    const char* file;
+    int line;
+    std::atomic<uint16_t> id{0};  // 0表示尚未注册
+};
+
+namespace binary_log_detail {
+
+constexpr size_t MAX_STRING_SIZE = 1024;  // 单个字符串参数最多记录的字节数
+
+template <typename T, typename Enable = void>
+struct ArgTraits;
+
+// 整数按符号和宽度归一为4字节或8字节
+template <typename T>
+struct ArgTraits<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>> {
+    using Stored = std::conditional_t<std::is_signed<T>::value,
+                                      std::conditional_t<(sizeof(T) <= 4), int32_t, int64_t>,
+                                      std::conditional_t<(sizeof(T) <= 4), uint32_t, uint64_t>>;
+    static constexpr char CODE = std::is_signed<T>::value ? (sizeof(T) <= 4 ? 'i' : 'l') : (sizeof(T) <= 4 ? 'u' : 'U');
+    static size_t size(T) {
+        return sizeof(Stored);
+    }
+    static uint8_t* write(uint8_t* dst, T value) {
+        Stored stored = static_cast<Stored>(value);
+        memcpy(dst, &stored, sizeof(stored));
+        return dst + sizeof(stored);
+    }
+};
+
+template <>
+struct ArgTraits<bool> {
+    static constexpr char CODE = 'b';
+    static size_t size(bool) {
+        return 1;
+    }
+    static uint8_t* write(uint8_t* dst, bool value) {
+        *dst = value ? 1 : 0;
+        return dst + 1;
+    }
+};
+
+template <typename T>
+struct ArgTraits<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+    static constexpr char CODE = 'd';
+    static size_t size(T) {
+        return sizeof(double);
+    }
+    static uint8_t* write(uint8_t* dst, T value) {
+        double stored = static_cast<double>(value);
+        memcpy(dst, &stored, sizeof(stored));
+        return dst + sizeof(stored);
+    }
+};
+
+template <typename T>
+struct ArgTraits<T, std::enable_if_t<std::is_enum<T>::value>> {
+    using Underlying = ArgTraits<std::underlying_type_t<T>>;
+    static constexpr char CODE = Underlying::CODE;
+    static size_t size(T value) {
+        return Underlying::size(static_cast<std::underlying_type_t<T>>(value));
+    }
+    static uint8_t* write(uint8_t* dst, T value) {
+        return Underlying::write(dst, static_cast<std::underlying_type_t<T>>(value));
+    }
+};
+
+struct StringArgTraits {
+    static constexpr char CODE = 's';
+    static size_t size(std::string_view value) {
+        return sizeof(uint16_t) + std::min(value.size(), MAX_STRING_SIZE);
+    }
+    static uint8_t* write(uint8_t* dst, std::string_view value) {
+        uint16_t length = static_cast<uint16_t>(std::min(value.size(), MAX_STRING_SIZE));
+        memcpy(dst, &length, sizeof(length));
+        memcpy(dst + sizeof(length), value.data(), length);
+        return dst + sizeof(length) + length;
+    }
+};
+
+template <>
+struct ArgTraits<std::string> : StringArgTraits {};
+template <>
+struct ArgTraits<std::string_view> : StringArgTraits {};
+template <>
+struct ArgTraits<const char*> : StringArgTraits {};
+template <>
+struct ArgTraits<char*> : StringArgTraits {};
+
+template <typename T>
+using Traits = ArgTraits<std::decay_t<T>>;
+
+}  // namespace binary_log_detail
+
+// 二进制结构化日志
+// 每次调用只记录调用点id, 时间戳和参数的原始字节, 不做任何格式化; 格式串按调用点只写入一次,
+// 由x30_log_decode离线还原为文本. 写入方式与TrafficRecorder相同: 持锁后直接拷贝进内存映射文件
+// 未open时调用只有一次原子读
+class BinaryLogger {
+public:
+    static constexpr char MAGIC[8] = {'X', '3', '0', 'B', 'L', 'G', '0', '1'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t DEFAULT_MAX_FILE_SIZE = 64 * 1024 * 1024;
+    static constexpr size_t DEFAULT_MAX_FILES = 3;
+
+    static BinaryLogger& getInstance() {
+        static BinaryLogger instance;
+        return instance;
+    }
+
+    // 单个文件超过max_file_size时滚动, 与文本日志的rotating_file_sink一致:
+    // path -> path.1 -> ... -> path.max_files, 超出的最旧文件删除; 新文件重写全部格式定义, 可单独解码
+    // 打开时已有的文件同样先滚动保留, 不覆盖上一次运行的记录
+    // 滚动不在记录日志的线程中做文件I/O: 后台线程x30-blog预先映射好下一个文件, 写满时只交换映射,
+    // 旧文件的截断、关闭和改名都由后台线程完成; 后台线程来不及准备时丢弃记录并计数, 不阻塞调用方
+    bool open(const std::string& path, size_t max_file_size = DEFAULT_MAX_FILE_SIZE,
+              size_t max_files = DEFAULT_MAX_FILES);
+    void close();
+    bool isOpen() const {
+        return open_.load(std::memory_order_acquire);
+    }
+
+    template <typename... Args>
+    void log(BinaryLogSite& site, const char* format, const Args&... args) {
+        if (!isOpen()) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        uint16_t id = site.id.load(std::memory_order_acquire);
+        if (id == 0) {
+            static const char signature[] = {binary_log_detail::Traits<Args>::CODE..., '\0'};
+            id = registerSite(site, format, signature);
+        }
+
+        size_t length = (size_t{0} + ... + binary_log_detail::Traits<Args>::size(args));
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint8_t* dst = beginRecord(BinaryLogRecordType::ENTRY, id, length, now);
+        if (dst == nullptr) {
+            return;
+        }
+        ((dst = binary_log_detail::Traits<Args>::write(dst, args)), ...);
+        (void)dst;
+    }
+
+private:
+    struct Format {
+        spdlog::level::level_enum level;
+        const char* file;
+        int line;
+        const char* format;
+        const char* signature;
+    };
+
+    BinaryLogger() = default;
+    ~BinaryLogger();
+    BinaryLogger(const BinaryLogger&) = delete;
+    BinaryLogger& operator=(const BinaryLogger&) = delete;
+
+    uint16_t registerSite(BinaryLogSite& site, const char* format, const char* signature);
+
+    // 一个已映射的日志文件, 映射大小固定为max_file_size_
+    struct Segment {
+        int fd = -1;
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+        size_t offset = 0;
+    };
+
+    // 以下调用方需持有mutex_
+    // 预留一条记录并写入记录头, 返回内容的写入位置; 未打开或空间不足时返回nullptr
+    uint8_t* beginRecord(BinaryLogRecordType type, uint16_t format_id, size_t length,
+                         std::chrono::steady_clock::time_point now);
+    void writeFormat(uint16_t format_id, const Format& format);
+    // 切换到segment, 写入文件头和全部格式定义, 只有内存拷贝
+    void startSegment(const Segment& segment);
+    // 当前文件写满, 换上后台预先映射好的下一个文件, 旧文件交给后台线程收尾; 下一个文件未就绪时返回false
+    bool switchSegment();
+
+    // 以下涉及文件I/O, 不持有mutex_调用
+    // 新建文件并映射max_file_size_字节
+    bool createSegment(const std::string& path, Segment& segment) const;
+    // 解除映射, 截掉预留的空白部分并关闭
+    void finishSegment(Segment& segment) const;
+    // 按rotating_file_sink的命名把已有文件依次后移: path -> path.1 -> ... -> path.max_files
+    void rotateFiles() const;
+    // 后台线程: 收尾写满的文件并滚动文件名, 预先映射下一个文件
+    void segmentLoop();
+
+    std::atomic<bool> open_{false};
+    std::mutex mutex_;
+    std::vector<Format> formats_;  // 下标为format_id - 1
+    std::string path_;
+    std::string next_path_;  // 预先映射的下一个文件在启用前的临时文件名
+    size_t max_file_size_ = DEFAULT_MAX_FILE_SIZE;
+    size_t max_files_ = DEFAULT_MAX_FILES;
+    int fd_ = -1;
+    uint8_t* data_ = nullptr;
+    size_t capacity_ = 0;
+    size_t offset_ = 0;
+    std::optional<Segment> next_;     // 后台线程准备好的下一个文件
+    std::optional<Segment> retired_;  // 已写满, 等待后台线程收尾的文件
+    uint64_t dropped_ = 0;            // 下一个文件未就绪时丢弃的记录数
+    uint64_t reported_dropped_ = 0;
+    bool stopping_ = false;
+    std::condition_variable segment_cv_;
+    std::thread segment_thread_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace common
+
+// 二进制日志, 用法与spdlog相同: X30_BLOG(spdlog::level::info, "坐标: [{:.5f}, {:.5f}]", x, y);
+// 格式串必须是字符串字面量, 参数支持整数, 浮点, bool, 枚举和字符串
+#define X30_BLOG(level, ...)                                                               \
+    do {                                                                                   \
+        static ::common::BinaryLogSite x30_blog_site_{(level), __FILE__, __LINE__};        \
+        ::common::BinaryLogger::getInstance().log(x30_blog_site_, __VA_ARGS__);            \
+    } while (0)
@@ -1,10 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <unordered_map>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#include "common/event_pool.hpp"
+#include "common/metrics.hpp"
+#include "common/probes.hpp"
 #include "protocol/x30_protocol.hpp"
 
 namespace common {
@@ -16,68 +26,219 @@ public:
     virtual std::string getType() const = 0;
 };
 
-// 事件处理器类型
-using EventHandler = std::function<void(const std::shared_ptr<Event>&)>;
-
 // 事件总线
 // 优点：
 // 1. 解耦：事件发送者和事件处理器解耦
 // 2. 灵活：可以随时添加和删除事件处理器
 // 3. 可扩展：可以随时添加和删除事件类型;   增加事件类型时， 不需要修改现有代码，比如日志， 监控等
-// 缺点：
-// 1. 性能：事件处理器需要遍历所有事件类型和处理器
-// 2. 内存：事件处理器需要存储所有事件处理器
+// 实现：
+// 每个事件类型在首次使用时分配一个稠密的整数id, 处理器按id存放在连续数组中;
+// publish<T>按静态类型直接定位处理器列表, 不做字符串哈希和shared_ptr<Event>向下转型
+// 处理器表是不可变快照, subscribe/unsubscribe复制后原子替换, publish只原子读取快照, 调用处理器时不持有任何锁,
+// 因此处理器中可以再次publish/subscribe; 取消注册后, 已取得旧快照的publish仍可能再调用一次该处理器
+// 异步投递:
+// 以DeliveryMode::ASYNC注册的处理器拥有独立的有界邮箱, publish只拷贝一次事件并投入各邮箱后立即返回,
+// 由分发线程池执行处理器; 同一邮箱同一时刻只会被一个分发线程处理, 因此单个订阅者内事件严格保持发布顺序,
+// 不同订阅者之间不保证顺序. 适合日志, 监控, 存储等不能拖慢网络线程和消息处理线程的遥测消费者
+// 异步投递的事件拷贝来自按类型的EventPool, 邮箱是预分配的环形缓冲, 就绪队列是侵入式链表,
+// 因此稳态下同步和异步publish都不分配内存
 class EventBus {
 public:
+    using HandlerId = uint64_t;
+    static constexpr HandlerId INVALID_HANDLER_ID = 0;
+    static constexpr size_t DISPATCH_THREADS = 2;    // 分发线程数, 首个异步订阅者注册时启动
+    static constexpr size_t EVENT_POOL_SIZE = 1024;  // 每种事件类型最多缓存的异步事件拷贝数
+
+    enum class DeliveryMode {
+        SYNC,   // 在publish线程中直接调用
+        ASYNC,  // 投入订阅者邮箱, 由分发线程调用
+    };
+
+    // 邮箱满时的处理策略
+    enum class MailboxOverflowPolicy {
+        DROP_OLDEST,  // 丢弃邮箱中最旧的事件, 适合只关心最新状态的遥测消费者
+        DROP_NEWEST,  // 丢弃新发布的事件
+        BLOCK,        // 阻塞publish直到有空位; 处理器中向自身邮箱发布会死锁
+    };
+
+    struct SubscribeOptions {
+        DeliveryMode mode = DeliveryMode::SYNC;
+        size_t mailbox_capacity = 1024;
+        MailboxOverflowPolicy overflow_policy = MailboxOverflowPolicy::DROP_OLDEST;
+    };
+
+    template <typename T>
+    using Handler = std::function<void(const T&)>;
+
     static EventBus& getInstance() {
         static EventBus instance;
         return instance;
     }
 
-    // 注册事件处理器
+    // 事件类型id, 同一类型在进程内唯一且稳定
     template <typename T>
-    std::string subscribe(EventHandler handler) {
-        static_assert(std::is_base_of<Event, T>::value, "T must inherit from Event");
-
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::string eventType = T().getType();
-        std::string handlerId = generateHandlerId();
-        handlers_[eventType][handlerId] = handler;
-        return handlerId;
+    static size_t typeId() {
+        static const size_t id = nextTypeId();
+        return id;
     }
 
     // 注册事件处理器
     template <typename T>
-    std::string subscribe(EventHandler handler, const std::string& handlerId) {
+    HandlerId subscribe(Handler<T> handler, SubscribeOptions options = {}) {
         static_assert(std::is_base_of<Event, T>::value, "T must inherit from Event");
+        static_assert(std::is_copy_constructible<T>::value, "T must be copy constructible");
+
+        std::function<void(const Event&)> invoke = [handler = std::move(handler)](const Event& event) {
+            handler(static_cast<const T&>(event));
+        };
+        std::shared_ptr<Mailbox> mailbox;
+        if (options.mode == DeliveryMode::ASYNC) {
+            mailbox = std::make_shared<Mailbox>(std::move(invoke), options);
+            startDispatcher();
+        }
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::string eventType = typeid(T).name();
-        handlers_[eventType][handlerId] = handler;
-        return handlerId;
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto slots = std::make_shared<Slots>(*std::atomic_load(&slots_));
+        size_t type_id = typeId<T>();
+        if (slots->size() <= type_id) {
+            slots->resize(type_id + 1);
+        }
+        HandlerId handler_id = ++handler_counter_;
+        // 处理器按静态类型包装, 调用时直接static_cast, 无需运行时类型检查
+        if (mailbox) {
+            mailbox->id = handler_id;
+        }
+        (*slots)[type_id].push_back({handler_id, std::move(invoke), std::move(mailbox)});
+        std::atomic_store(&slots_, std::shared_ptr<const Slots>(std::move(slots)));
+        return handler_id;
     }
 
-    // 取消注册事件处理器
-    void unsubscribe(const std::string& eventType, const std::string& handlerId);
+    // 取消注册事件处理器; 异步处理器邮箱中尚未投递的事件被丢弃, 但正在执行的那一次调用不会被打断
+    void unsubscribe(HandlerId handler_id);
+
+    // 异步处理器因邮箱溢出丢弃的事件数, 同步处理器或未知id返回0
+    uint64_t droppedEvents(HandlerId handler_id) const;
 
     // 发布事件
-    void publish(const std::shared_ptr<Event>& event);
-    void publish(const std::shared_ptr<Event>& event, const std::string& handlerId);
+    template <typename T>
+    void publish(const T& event) {
+        static_assert(std::is_base_of<Event, T>::value, "T must inherit from Event");
+
+        auto& metrics = busMetrics();
+        metrics.published.inc();
+        ScopedTimer timer(metrics.publish_duration);
+        auto slots = std::atomic_load(&slots_);
+        size_t type_id = typeId<T>();
+        X30_PROBE3(event_publish, type_id, typeid(T).name(),
+                   type_id < slots->size() ? (*slots)[type_id].size() : size_t{0});
+        if (type_id >= slots->size() || (*slots)[type_id].empty()) {
+            warnNoHandler(event);
+            return;
+        }
+        std::shared_ptr<const Event> copy;  // 所有异步订阅者共享同一份拷贝
+        for (const auto& subscription : (*slots)[type_id]) {
+            if (!subscription.mailbox) {
+                subscription.invoke(event);
+                continue;
+            }
+            if (!copy) {
+                copy = eventPool<T>().acquire(event);
+            }
+            post(subscription.mailbox, copy);
+        }
+    }
+
+    // 异步投递使用的事件池, 可用于观察池的大小和未命中次数
+    template <typename T>
+    static EventPool<T>& eventPool() {
+        static EventPool<T> pool(EVENT_POOL_SIZE);
+        return pool;
+    }
 
 private:
+    // 异步订阅者的邮箱; scheduled表示邮箱已在就绪队列中或正被某个分发线程处理, 保证单线程消费
+    struct Mailbox {
+        Mailbox(std::function<void(const Event&)> invoke, const SubscribeOptions& options)
+            : invoke(std::move(invoke)),
+              capacity(std::max<size_t>(options.mailbox_capacity, 1)),
+              overflow_policy(options.overflow_policy),
+              events(capacity) {}
+
+        bool full() const {
+            return count == capacity;
+        }
+        void pushBack(std::shared_ptr<const Event> event) {
+            events[(head + count) % capacity] = std::move(event);
+            ++count;
+        }
+        std::shared_ptr<const Event> popFront() {
+            auto event = std::move(events[head]);
+            head = (head + 1) % capacity;
+            --count;
+            return event;
+        }
+        void clear() {
+            while (count > 0) {
+                popFront();
+            }
+        }
+
+        HandlerId id = INVALID_HANDLER_ID;
+        const std::function<void(const Event&)> invoke;
+        const size_t capacity;
+        const MailboxOverflowPolicy overflow_policy;
+
+        std::mutex mutex;
+        std::condition_variable not_full_cv;
+        std::vector<std::shared_ptr<const Event>> events;  // 环形缓冲
+        size_t head = 0;
+        size_t count = 0;
+        bool scheduled = false;
+        bool closed = false;
+        std::atomic<uint64_t> dropped{0};
+
+        std::shared_ptr<Mailbox> next_ready;  // 就绪队列链接, 由dispatch_mutex_保护
+    };
+
+    struct Subscription {
+        HandlerId id;
+        std::function<void(const Event&)> invoke;
+        std::shared_ptr<Mailbox> mailbox;  // 同步处理器为空
+    };
+    using Slots = std::vector<std::vector<Subscription>>;  // 按事件类型id索引
+
+    struct BusMetrics {
+        Counter& published;
+        Histogram& publish_duration;  // publish耗时, 含同步处理器执行和异步投递
+        Counter& async_dropped;
+        Histogram& dispatch_duration;  // 分发线程中单次异步处理器执行耗时
+    };
+    static BusMetrics& busMetrics();
+
     EventBus() = default;
-    ~EventBus() = default;
+    ~EventBus();
     EventBus(const EventBus&) = delete;
     EventBus& operator=(const EventBus&) = delete;
 
-    // 生成唯一的处理器ID
-    std::string generateHandlerId() {
-        return std::to_string(++handler_counter_);
-    }
+    static size_t nextTypeId();
+    static void warnNoHandler(const Event& event);
 
-    std::mutex mutex_;
-    std::unordered_map<std::string, std::unordered_map<std::string, EventHandler>> handlers_;
-    uint64_t handler_counter_ = 0;
+    void post(const std::shared_ptr<Mailbox>& mailbox, std::shared_ptr<const Event> event);
+    void schedule(std::shared_ptr<Mailbox> mailbox);
+    void startDispatcher();
+    void dispatchLoop();
+
+    std::mutex write_mutex_;  // 串行化subscribe/unsubscribe, publish不使用
+    std::shared_ptr<const Slots> slots_ = std::make_shared<const Slots>();
+    HandlerId handler_counter_ = 0;
+
+    // 分发线程池
+    std::mutex dispatch_mutex_;
+    std::condition_variable dispatch_cv_;
+    std::shared_ptr<Mailbox> ready_head_;  // 就绪邮箱侵入式链表
+    Mailbox* ready_tail_ = nullptr;
+    std::vector<std::thread> dispatch_threads_;
+    bool dispatch_stopping_ = false;
 };
 
 // 常用事件定义
@@ -87,6 +248,23 @@ struct NetworkErrorEvent : public Event {
         return "NetworkError";
     }
     std::string message;
+    uint64_t connection_id = 0;  // 出错连接的编号(BaseNetworkModel::connectionId), 用于识别过期的错误
+};
+
+// 网络重连成功事件
+struct NetworkReconnectedEvent : public Event {
+    std::string getType() const override {
+        return "NetworkReconnected";
+    }
+    int attempts = 0;  // 本次恢复所用的重连次数
+};
+
+// 网络重连失败事件, 重连次数耗尽后发布
+struct NetworkReconnectFailedEvent : public Event {
+    std::string getType() const override {
+        return "NetworkReconnectFailed";
+    }
+    std::string message;
 };
 
 struct QueryStatusEvent : public Event {
@@ -99,13 +277,18 @@ struct QueryStatusEvent : public Event {
     std::string timestamp;
     protocol::ErrorCode errorCode;
 
+    // 原地填充, timestamp沿用已有容量; 发布方复用同一个事件对象时不再分配内存
+    void assign(const protocol::QueryStatusResponse& resp) {
+        status = resp.status;
+        value = resp.value;
+        timestamp.assign(resp.timestamp);
+        errorCode = resp.errorCode;
+    }
+
     // 便于构造的静态工厂方法
-    static std::shared_ptr<QueryStatusEvent> fromResponse(const protocol::QueryStatusResponse& resp) {
-        auto event = std::make_shared<QueryStatusEvent>();
-        event->status = resp.status;
-        event->value = resp.value;
-        event->timestamp = resp.timestamp;
-        event->errorCode = resp.errorCode;
+    static QueryStatusEvent fromResponse(const protocol::QueryStatusResponse& resp) {
+        QueryStatusEvent event;
+        event.assign(resp);
         return event;
     }
 };
@@ -122,15 +305,20 @@ struct GetRealTimeStatusEvent : public Event {
     double sumOdom;  // 累计里程
     int location;    // 位置  定位正常=0, 定位丢失=1
 
+    // 原地填充, timestamp沿用已有容量; 发布方复用同一个事件对象时不再分配内存
+    void assign(const protocol::GetRealTimeStatusResponse& resp) {
+        timestamp.assign(resp.timestamp);
+        posX = resp.posX;
+        posY = resp.posY;
+        posZ = resp.posZ;
+        sumOdom = resp.sumOdom;
+        location = resp.location;
+    }
+
     // 便于构造的静态工厂方法
-    static std::shared_ptr<GetRealTimeStatusEvent> fromResponse(const protocol::GetRealTimeStatusResponse& resp) {
-        auto event = std::make_shared<GetRealTimeStatusEvent>();
-        event->timestamp = resp.timestamp;
-        event->posX = resp.posX;
-        event->posY = resp.posY;
-        event->posZ = resp.posZ;
-        event->sumOdom = resp.sumOdom;
-        event->location = resp.location;
+    static GetRealTimeStatusEvent fromResponse(const protocol::GetRealTimeStatusResponse& resp) {
+        GetRealTimeStatusEvent event;
+        event.assign(resp);
         return event;
     }
 };
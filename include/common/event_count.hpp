@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace common {
+
+// 基于futex的事件计数器, 用于无锁结构在空闲时阻塞等待
+// 等待方: key = prepareWait(); 再次检查条件; 条件满足则cancelWait(), 否则wait(key)
+// 通知方: 先使条件成立, 再调用notify, 唤醒当前所有等待方
+// 没有等待方, 或等待方已被唤醒但尚未运行时, notify只有一次原子读, 不进入内核
+class EventCount {
+public:
+    uint64_t prepareWait();
+    void cancelWait(uint64_t key);
+    void wait(uint64_t key);
+    // 带超时的wait, 被notify唤醒返回true; 超时返回false, 此时登记已被撤销, 无需再cancelWait
+    bool waitFor(uint64_t key, std::chrono::nanoseconds timeout);
+
+    void notify();
+
+private:
+    // 高32位为纪元, 低32位为等待方个数; futex等待在纪元所在的32位上
+    std::atomic<uint64_t> state_{0};
+};
+
+}  // namespace common
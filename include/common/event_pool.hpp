@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace common {
+
+// 可回收的事件存储
+// 每个槽位是一个长期存活的T对象和一块shared_ptr控制块的存储; 复用时对已有对象做拷贝赋值,
+// std::string等成员沿用已有容量, 控制块也放在槽位自带的存储中, 稳态下不再调用全局分配器.
+// 空闲槽位的下标保存在互斥锁保护的栈中, 取用和归还都是O(1), 锁内只有一次压栈或出栈.
+// 最后一个引用释放时控制块被回收, 此时才把槽位下标压回空闲栈, 保证槽位不会在仍被引用时复用
+// 池满且没有空闲槽位时退化为make_shared, 并计入misses
+template <typename T>
+class EventPool {
+public:
+    explicit EventPool(size_t max_size) : storage_(std::make_shared<Storage>(max_size)) {
+    }
+
+    EventPool(const EventPool&) = delete;
+    EventPool& operator=(const EventPool&) = delete;
+
+    std::shared_ptr<const T> acquire(const T& value) {
+        Slot* slot = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(storage_->mutex);
+            if (!storage_->free.empty()) {
+                slot = storage_->free.back();
+                storage_->free.pop_back();
+            }
+            else if (storage_->slots.size() < storage_->max_size) {
+                storage_->slots.push_back(std::make_unique<Slot>());
+                slot = storage_->slots.back().get();
+            }
+        }
+        if (slot == nullptr) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return std::make_shared<const T>(value);
+        }
+        // 出栈后槽位只属于当前线程, 赋值不需要持锁
+        slot->value = value;
+        return std::shared_ptr<const T>(&slot->value, NoopDeleter{}, SlotAllocator<T>(storage_, slot));
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(storage_->mutex);
+        return storage_->slots.size();
+    }
+
+    uint64_t misses() const {
+        return misses_.load(std::memory_order_relaxed);
+    }
+
+private:
+    // 足够容纳libstdc++/libc++中带删除器和分配器的控制块
+    static constexpr size_t CONTROL_BLOCK_SIZE = 64;
+
+    struct Slot {
+        T value{};
+        alignas(std::max_align_t) unsigned char control[CONTROL_BLOCK_SIZE];
+    };
+
+    // 池对象可能先于仍在邮箱中的事件析构(静态对象析构顺序), 槽位存储由池和每个在用的控制块共同持有
+    struct Storage {
+        explicit Storage(size_t max) : max_size(max) {
+            slots.reserve(max_size);
+            free.reserve(max_size);
+        }
+        const size_t max_size;
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<Slot>> slots;
+        std::vector<Slot*> free;  // 空闲槽位栈
+    };
+
+    // 对象本身随槽位长期存活, 引用释放时不析构
+    struct NoopDeleter {
+        void operator()(const T*) const {
+        }
+    };
+
+    // 把控制块放进槽位自带的存储, 回收控制块时归还槽位
+    template <typename U>
+    struct SlotAllocator {
+        using value_type = U;
+
+        SlotAllocator(std::shared_ptr<Storage> storage, Slot* slot) : storage(std::move(storage)), slot(slot) {
+        }
+        template <typename V>
+        SlotAllocator(const SlotAllocator<V>& other) : storage(other.storage), slot(other.slot) {
+        }
+
+        U* allocate(size_t n) {
+            static_assert(sizeof(U) <= CONTROL_BLOCK_SIZE && alignof(U) <= alignof(std::max_align_t),
+                          "shared_ptr控制块超出槽位预留的存储");
+            if (n != 1) {
+                throw std::bad_alloc();
+            }
+            return reinterpret_cast<U*>(slot->control);
+        }
+
+        // 分配器在控制块销毁前被拷贝出来, 此处持有的storage保证归还时存储仍然有效
+        void deallocate(U*, size_t) {
+            std::lock_guard<std::mutex> lock(storage->mutex);
+            storage->free.push_back(slot);
+        }
+
+        template <typename V>
+        bool operator==(const SlotAllocator<V>& other) const {
+            return slot == other.slot;
+        }
+        template <typename V>
+        bool operator!=(const SlotAllocator<V>& other) const {
+            return slot != other.slot;
+        }
+
+        std::shared_ptr<Storage> storage;
+        Slot* slot;
+    };
+
+    const std::shared_ptr<Storage> storage_;
+    std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace common
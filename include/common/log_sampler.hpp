@@ -0,0 +1,73 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace common {
+
+// 日志采样, 用于按样本上报的遥测日志(2002实时状态, 2007状态查询等), 避免高频日志刷满磁盘和占用CPU
+// LogRateLimiter: 令牌桶限流, 被抑制的条数在下一次放行时汇总为一行"抑制了N条"
+// ChangeFilter: 仅在取值变化时放行, 用于定位状态, 导航状态等缓慢变化的字段
+// 按机器人区分时, 由每个机器人对应的对象(如X30InspectionSystem)各自持有限流器和过滤器;
+// 没有这类对象的调用点使用X30_LOG_SAMPLED, 每个调用点一个静态限流器
+
+// 令牌桶限流器, 线程安全
+class LogRateLimiter {
+public:
+    // rate_per_second: 平均每秒放行条数; burst: 桶容量, 即允许的突发条数
+    LogRateLimiter(std::string name, double rate_per_second, double burst);
+
+    // 放行返回true; 放行前若有被抑制的日志, 先以同一级别输出一条汇总
+    bool allow(spdlog::level::level_enum level);
+
+    // 累计被抑制的条数
+    uint64_t suppressedTotal() const;
+
+private:
+    const std::string name_;
+    const double rate_per_second_;
+    const double burst_;
+
+    mutable std::mutex mutex_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_refill_;
+    uint64_t suppressed_ = 0;        // 上一次放行以来被抑制的条数
+    uint64_t suppressed_total_ = 0;
+};
+
+// 仅在取值变化时放行, 首次调用总是放行; 非线程安全, 由单一线程调用
+template <typename T>
+class ChangeFilter {
+public:
+    bool changed(const T& value) {
+        if (has_value_ && value == last_) {
+            return false;
+        }
+        last_ = value;
+        has_value_ = true;
+        return true;
+    }
+
+    void reset() {
+        has_value_ = false;
+    }
+
+private:
+    T last_{};
+    bool has_value_ = false;
+};
+
+}  // namespace common
+
+// 按调用点限流的日志, 被抑制时不会对参数求值
+// 用法: X30_LOG_SAMPLED("NavFsm:no_transition", 1.0, 5, spdlog::level::warn, "[{}]: ...", args...);
+#define X30_LOG_SAMPLED(name, rate_per_second, burst, level, ...)                                           \
+    do {                                                                                                     \
+        static ::common::LogRateLimiter x30_log_sampled_limiter_((name), (rate_per_second), (burst));       \
+        if (x30_log_sampled_limiter_.allow(level)) {                                                         \
+            spdlog::log(level, __VA_ARGS__);                                                                 \
+        }                                                                                                    \
+    } while (0)
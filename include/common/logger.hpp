@@ -3,12 +3,23 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 #include <iostream>
+#include "common/async_log_sink.hpp"
+#include "common/binary_log.hpp"
 
 namespace common {
 
+struct LoggerOptions {
+    bool async = true;            // 异步模式下控制台和文件I/O在后台写线程中完成
+    size_t queue_capacity = 8192;  // 异步日志队列容量, 预先分配
+    AsyncLogOverflowPolicy overflow_policy = AsyncLogOverflowPolicy::DROP_NEWEST;
+    std::string binary_log_path = "logs/x30_telemetry.blog";  // X30_BLOG二进制日志文件, 为空时不记录
+    size_t binary_log_max_size = BinaryLogger::DEFAULT_MAX_FILE_SIZE;  // 二进制日志单文件上限, 超过后滚动
+    size_t binary_log_max_files = BinaryLogger::DEFAULT_MAX_FILES;     // 保留的历史二进制日志文件数
+};
+
 class Logger {
 public:
-    static void init(const std::string& log_path = "logs/x30_inspection.log") {
+    static void init(const std::string& log_path = "logs/x30_inspection.log", const LoggerOptions& options = {}) {
         try {
             // 创建控制台sink
             auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
@@ -22,6 +33,11 @@ public:
 
             // 创建logger
             std::vector<spdlog::sink_ptr> sinks{console_sink, file_sink};
+            if (options.async) {
+                auto async_sink = std::make_shared<AsyncLogSink>(std::move(sinks), options.queue_capacity,
+                                                                 options.overflow_policy);
+                sinks = {async_sink};
+            }
             auto logger = std::make_shared<spdlog::logger>("x30", sinks.begin(), sinks.end());
 
             // 设置格式
@@ -32,13 +48,20 @@ public:
             spdlog::set_default_logger(logger);
 
             spdlog::info("Logger initialized");
+
+            if (!options.binary_log_path.empty()) {
+                BinaryLogger::getInstance().open(options.binary_log_path, options.binary_log_max_size,
+                                                 options.binary_log_max_files);
+            }
         }
         catch (const spdlog::spdlog_ex& ex) {
             std::cerr << "Log initialization failed: " << ex.what() << std::endl;
         }
     }
 
+    // 异步模式下等待队列中的日志写完再释放
     static void shutdown() {
+        BinaryLogger::getInstance().close();
         spdlog::shutdown();
     }
 };
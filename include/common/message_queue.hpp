@@ -1,32 +1,98 @@
 #pragma once
-#include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include <queue>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
 #include "protocol/x30_protocol.hpp"
 
 namespace common {
 
+// 消息队列实现类型
+enum class MessageQueueType {
+    LOCKED,     // 互斥锁+条件变量
+    LOCK_FREE,  // 有界无锁多生产者单消费者环形队列, 空闲时基于futex阻塞
+};
+
+// 超出内存预算时的处理策略, 控制消息不受预算限制, 始终入队
+enum class OverflowPolicy {
+    // 丢弃最早的遥测消息腾出空间, 没有可丢弃的遥测时拒绝新消息
+    // LOCK_FREE下生产者无法从环中取出消息, 退化为丢弃新到的遥测、拒绝其他新消息
+    DROP_OLDEST_TELEMETRY,
+    REJECT_NEW,      // 拒绝新消息
+    BLOCK_PRODUCER,  // 阻塞生产者直到有空间或队列关闭
+};
+
+// 消息优先级, 数值越小越先处理, 同一优先级内保持先进先出
+enum class MessagePriority {
+    CONTROL = 0,    // 用户命令与内部控制消息, 如取消任务、导航过程重置
+    MISSION = 1,    // 任务响应, 驱动状态机
+    TELEMETRY = 2,  // 实时状态等遥测响应
+};
+
+// 消息队列配置
+struct MessageQueueOptions {
+    MessageQueueType type = MessageQueueType::LOCKED;
+    size_t capacity = 4096;  // LOCK_FREE下每个优先级通道的容量, 通道满时与超出预算同样按overflow_policy处理
+    // 遥测合并: 新的遥测消息就地替换尚未被取走的同类型旧消息, 任务与控制消息不受影响
+    bool conflate_telemetry = false;
+    // 内存预算, 0表示不限制; 字节数按IMessage::memoryUsage估算
+    size_t max_messages = 0;
+    size_t max_bytes = 0;
+    OverflowPolicy overflow_policy = OverflowPolicy::DROP_OLDEST_TELEMETRY;
+    std::string name = "default";  // 指标标签queue的取值
+};
+
+// 消息队列统计
+struct MessageQueueStats {
+    size_t messages = 0;              // 当前消息条数
+    size_t bytes = 0;                 // 当前估算字节数
+    size_t high_water_messages = 0;   // 消息条数峰值
+    size_t high_water_bytes = 0;      // 字节数峰值
+    uint64_t superseded = 0;          // 遥测合并时被替换掉的消息条数
+    uint64_t dropped_telemetry = 0;   // 超出预算时丢弃的遥测消息条数
+    uint64_t rejected = 0;            // 超出预算时拒绝的新消息条数
+    uint64_t blocked = 0;             // 超出预算时生产者阻塞的次数
+    uint64_t purged = 0;              // 被purge/clear丢弃的消息条数
+    uint64_t enqueued = 0;            // 累计入队条数, 含合并替换
+};
+
 // 消息队列目的
 // 1. 解耦：消息发送者和消息处理器解耦
-// 2. 线程安全：使用互斥锁和条件变量保证线程安全
+// 2. 线程安全：多个生产者(网络线程、命令行线程、状态机)可并发push, 由单个消息处理线程pop
+// 3. 优先级：按MessagePriority分道, 突发遥测不会延迟控制消息
+// 4. 有界：可设置条数/字节预算, 超出时按OverflowPolicy处理并计数
+// LOCK_FREE下pop、clear和purge只能在消息处理线程调用; 环满时按OverflowPolicy处理, 控制通道环满时阻塞直到有空位或队列关闭
 class MessageQueue {
 public:
-    MessageQueue() = default;
-    ~MessageQueue() = default;
-    void push(std::unique_ptr<protocol::IMessage> msg);
+    static constexpr size_t LANE_COUNT = 3;
+
+    explicit MessageQueue(MessageQueueOptions options = MessageQueueOptions{});
+    ~MessageQueue();
+    // 返回false表示消息因超出预算或队列关闭被丢弃
+    bool push(std::unique_ptr<protocol::IMessage> msg);
     std::unique_ptr<protocol::IMessage> pop();
+    // 阻塞直到有消息, 按优先级一次取出最多max条追加到out, 返回取出的条数; 队列关闭且为空时返回0
+    size_t drain(std::vector<std::unique_ptr<protocol::IMessage>>& out, size_t max);
     void clear();
+    // 丢弃指定类型的待处理消息, 其余消息保持原有顺序, 返回丢弃的条数
+    size_t purge(std::initializer_list<protocol::MessageType> types);
     void close();
 
+    MessageQueueStats stats() const;
+
+    static MessagePriority classify(protocol::MessageType type);
+
+    class Impl;
+
 private:
     const MessageQueue& operator=(const MessageQueue&) = delete;
     MessageQueue(const MessageQueue&) = delete;
 
-    std::queue<std::unique_ptr<protocol::IMessage>> queue_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    std::atomic<bool> close_flag_{false};
+    std::unique_ptr<Impl> impl_;
+    uint64_t collector_id_ = 0;
 };
 
 }  // namespace common
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace common {
+
+// 指标体系
+// Counter: 单调递增计数, 按线程分片累加, 读取时求和
+// Gauge: 可增可减的瞬时值
+// Histogram: HDR风格对数-线性直方图, 每个2的幂区间再线性分为16格, 相对误差不超过1/16, 用于耗时分布(纳秒)
+// 记录路径只有relaxed原子操作, 不加锁; 注册和采集加锁, 调用点应在首次使用时取得引用后缓存(如函数内static)
+// 指标注册后永不释放, 引用在进程生命周期内有效
+
+constexpr size_t METRIC_SHARDS = 16;
+
+// 当前线程使用的分片下标, 线程首次调用时轮转分配
+size_t metricShard();
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) {
+        shards_[metricShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, METRIC_SHARDS> shards_;
+};
+
+class Gauge {
+public:
+    void set(int64_t value) {
+        value_.store(value, std::memory_order_relaxed);
+    }
+    void add(int64_t delta) {
+        value_.fetch_add(delta, std::memory_order_relaxed);
+    }
+    int64_t value() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// 直方图快照, counts下标与Histogram::bucketIndex一致
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    std::vector<uint64_t> counts;
+
+    // q取值0~1, 返回所在格的上界; 没有样本时返回0
+    uint64_t percentile(double q) const;
+};
+
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 40;  // 超过2^41(约36分钟, 以纳秒计)的值计入最后一格
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    void record(uint64_t value) {
+        buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t value);
+    // 第index格包含的最大值
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> sum_{0};
+};
+
+// 作用域计时, 析构时将耗时(纳秒)记入直方图
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        histogram_.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+enum class MetricType {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM,
+};
+
+// 采集结果中的一条指标
+struct MetricSample {
+    std::string name;
+    std::string help;
+    std::string labels;  // 已格式化的标签, 如 direction="in", 可为空
+    MetricType type = MetricType::COUNTER;
+    double value = 0.0;  // COUNTER/GAUGE
+    HistogramSnapshot histogram;
+};
+
+// 指标注册表
+// 同名同标签重复注册返回同一个指标; 已有统计数据的模块(如MessageQueue)可注册采集回调, 采集时再读取
+class MetricsRegistry {
+public:
+    using CollectorId = uint64_t;
+    using Collector = std::function<void(std::vector<MetricSample>&)>;
+
+    static MetricsRegistry& getInstance() {
+        static MetricsRegistry instance;
+        return instance;
+    }
+
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    CollectorId addCollector(Collector collector);
+    void removeCollector(CollectorId id);
+
+    // 按注册顺序采集所有指标
+    std::vector<MetricSample> collect() const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        std::string labels;
+        MetricType type;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    Entry& findOrCreate(const std::string& name, const std::string& help, const std::string& labels, MetricType type);
+
+    mutable std::mutex mutex_;
+    std::deque<Entry> entries_;
+    std::vector<std::pair<CollectorId, Collector>> collectors_;
+    CollectorId collector_counter_ = 0;
+};
+
+}  // namespace common
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/metrics.hpp"
+#include "common/stop_token.hpp"
+
+namespace common {
+
+struct MetricsExporterOptions {
+    // 两个监听端点都使用HTTP/1.0, 路径 /metrics 返回Prometheus文本格式, /metrics.json 返回JSON,
+    // /trace.json 返回当前保留的消息追踪(Chrome trace JSON)
+    // UNIX域套接字, 为空时不监听; 读取示例: curl --unix-socket logs/x30_metrics.sock http://localhost/metrics
+    std::string unix_socket_path = "logs/x30_metrics.sock";
+    uint16_t http_port = 9630;  // 仅监听127.0.0.1, 为0时不监听
+    // 定期写入的JSON快照文件, 为空时不写; 先写临时文件再rename, 读取方不会读到半个文件
+    std::string snapshot_path = "logs/x30_metrics.json";
+    std::chrono::milliseconds snapshot_interval{10000};
+    // 导出线程x30-metrics的nice值和绑核统一由threads.json配置
+};
+
+// 将采集结果格式化为Prometheus文本格式(0.0.4)
+// 直方图每次输出同一组le(2^k-1, 即每个指数分组的上界)和+Inf, 没有样本的边界也输出, 序列不会时有时无;
+// 同名指标按名称归并, HELP/TYPE只输出一次
+std::string formatPrometheus(const std::vector<MetricSample>& samples);
+
+// 将采集结果格式化为JSON, 直方图输出count/sum和p50/p90/p99/p999/max
+std::string formatMetricsJson(const std::vector<MetricSample>& samples);
+
+// 本地指标导出
+// 在独立的低优先级线程中监听端点, 只在被拉取或写快照时调用MetricsRegistry::collect,
+// 热路径线程不感知导出的存在; 不依赖任何外部服务
+class MetricsExporter {
+public:
+    explicit MetricsExporter(MetricsExporterOptions options = {});
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // 监听端点并启动导出线程; 端点绑定失败只告警, 不影响其余端点
+    void start();
+    void stop();
+
+private:
+    void exportLoop();
+    void openListeners();
+    void closeListeners();
+    void serve(int listen_fd);
+    void writeSnapshot();
+
+    MetricsExporterOptions options_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    StopToken stop_;  // stop时唤醒导出线程
+    std::vector<int> listen_fds_;
+    bool unix_socket_bound_ = false;  // 套接字文件由本实例创建, 关闭时才删除
+};
+
+}  // namespace common
@@ -0,0 +1,47 @@
+#pragma once
+
+// USDT静态探针
+// 构建时找到sys/sdt.h(systemtap-sdt-dev)则定义X30_HAVE_USDT, 探针编译为一条nop并在ELF的.note.stapsdt中登记,
+// 未挂载时没有额外开销; 否则探针为空操作, 参数不求值
+// 提供者为x30, 列出探针: bpftrace -l 'usdt:./x30_inspection_system:x30:*'
+// 示例, 统计解码到入队的分布:
+//   bpftrace -e 'usdt:./x30_inspection_system:x30:frame_received { @t[tid] = nsecs; }
+//                usdt:./x30_inspection_system:x30:queue_push /@t[tid]/ { @ns = hist(nsecs - @t[tid]); delete(@t[tid]); }'
+//
+// 探针及参数:
+//   frame_received(body_size)                  网络线程读完一帧
+//   frame_decoded(message_type, body_size)     消息体解析成功
+//   queue_push(message_type, accepted)         MessageQueue::push, accepted为0表示超出预算被拒绝
+//   queue_pop(message_type)                    MessageQueue::pop/drain取出一条消息
+//   event_publish(type_id, type_name, subscribers)  EventBus::publish
+//   state_entry(state_name)                    BaseState::on_entry
+//   state_exit(state_name, duration_ns)        BaseState::on_exit, duration_ns为在该状态停留的时长
+//   serialize_begin(message_type)              IMessage::serialize开始
+//   serialize_end(message_type, frame_size)    IMessage::serialize结束
+
+#if defined(X30_HAVE_USDT)
+#include <sys/sdt.h>
+
+#define X30_PROBE1(name, a1) DTRACE_PROBE1(x30, name, a1)
+#define X30_PROBE2(name, a1, a2) DTRACE_PROBE2(x30, name, a1, a2)
+#define X30_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(x30, name, a1, a2, a3)
+
+#else
+
+#define X30_PROBE1(name, a1) \
+    do {                     \
+        (void)sizeof(a1);    \
+    } while (0)
+#define X30_PROBE2(name, a1, a2) \
+    do {                         \
+        (void)sizeof(a1);        \
+        (void)sizeof(a2);        \
+    } while (0)
+#define X30_PROBE3(name, a1, a2, a3) \
+    do {                             \
+        (void)sizeof(a1);            \
+        (void)sizeof(a2);            \
+        (void)sizeof(a3);            \
+    } while (0)
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+
+namespace common {
+
+// 停止信号
+// 各线程循环统一通过它感知停止请求: 基于poll/epoll的循环把fd()加入关注集合, 请求停止后fd一直可读,
+// 阻塞中的等待立即返回, 不再依赖超时轮询. requestStop是异步信号安全的, 可在SIGTERM处理函数中调用
+class StopToken {
+public:
+    StopToken();
+    ~StopToken();
+
+    StopToken(const StopToken&) = delete;
+    StopToken& operator=(const StopToken&) = delete;
+
+    // 可重复调用, 只有第一次生效
+    void requestStop();
+    bool stopRequested() const {
+        return stopped_.load(std::memory_order_acquire);
+    }
+
+    // eventfd, 请求停止后可读
+    int fd() const {
+        return fd_;
+    }
+
+    // 清除停止状态, 供可重复启动的组件(如重连时重建的事件循环)复用; 调用时不能有线程在等待
+    void reset();
+
+private:
+    int fd_ = -1;
+    std::atomic<bool> stopped_{false};
+};
+
+}  // namespace common
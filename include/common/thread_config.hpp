@@ -0,0 +1,84 @@
+#pragma once
+
+#include <sched.h>
+#include <sys/types.h>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace common {
+
+// 线程调度策略
+struct ThreadPolicy {
+    std::vector<int> cpus;    // 绑定的CPU编号, 为空时不限制
+    int fifo_priority = 0;    // 1~99时使用SCHED_FIFO实时调度, 0为默认分时调度
+    std::optional<int> nice;  // 分时调度下的nice值, 未设置时恢复为进程默认值
+};
+
+// 线程CPU占用
+struct ThreadCpuUsage {
+    std::string name;
+    pid_t tid = 0;
+    double cpu_seconds = 0.0;  // 线程启动以来的用户态+内核态CPU时间
+    double cpu_percent = 0.0;  // 距上次统计期间的占用, 100表示占满一个核
+    int last_cpu = -1;         // 最近一次运行所在的CPU
+};
+
+// 线程管理
+// 各线程在入口处调用setupThread: 设置线程名(ps/top/perf中可见), 登记tid, 应用同名配置;
+// 配置可在线程启动前后加载, 加载时对已登记的线程立即生效. CPU占用从/proc/self/task/<tid>/stat读取,
+// 通过指标x30_thread_cpu_seconds_total导出. 没有配置的线程继承创建者的绑核和调度策略
+// 配置文件格式(JSON), 名称可写完整线程名, 或去掉末尾"-序号"后的组名(如x30-bus匹配x30-bus-0):
+//   {"threads": {"x30-epoll": {"cpus": [2], "fifo_priority": 50}, "x30-metrics": {"nice": 19}}}
+class ThreadManager {
+public:
+    // 有些线程在其他单例析构时才退出(如日志写线程、EventBus分发线程), 线程管理器有意不析构, 保证退出时仍可注销
+    static ThreadManager& getInstance() {
+        static ThreadManager* instance = new ThreadManager();
+        return *instance;
+    }
+
+    // 加载配置文件并应用到已登记的线程, 文件不存在时返回false且不改变现有配置
+    bool loadConfig(const std::string& path);
+    void setPolicy(const std::string& name, const ThreadPolicy& policy);
+
+    // 在线程入口调用, 线程名超过15字节时截断; 线程退出时自动注销
+    void setupCurrentThread(const std::string& name);
+
+    // 各登记线程的CPU占用, cpu_percent为距上次调用期间的占用
+    std::vector<ThreadCpuUsage> cpuUsage();
+    // 以日志输出各线程CPU占用
+    void logCpuUsage();
+
+private:
+    struct ThreadInfo {
+        std::string name;
+        double last_cpu_seconds = 0.0;
+        std::chrono::steady_clock::time_point last_sample;
+    };
+    struct ThreadHandle;
+
+    ThreadManager();
+    ThreadManager(const ThreadManager&) = delete;
+    ThreadManager& operator=(const ThreadManager&) = delete;
+
+    void unregisterThread(pid_t tid);
+    // 调用方需持有mutex_
+    const ThreadPolicy* findPolicy(const std::string& name) const;
+    void applyPolicy(pid_t tid, const std::string& name, const ThreadPolicy& policy) const;
+
+    cpu_set_t process_cpus_;
+    int process_nice_ = 0;  // 进程启动时的nice值, 配置未设置nice的线程恢复为该值
+    std::mutex mutex_;
+    std::unordered_map<std::string, ThreadPolicy> policies_;
+    std::unordered_map<pid_t, ThreadInfo> threads_;
+};
+
+inline void setupThread(const std::string& name) {
+    ThreadManager::getInstance().setupCurrentThread(name);
+}
+
+}  // namespace common
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace common {
+
+// 分层时间轮定时器
+// 所有周期任务和超时(定时1007查询、心跳检测等)共用一个x30-timer线程, 而不是每个任务一个睡眠线程
+// 精度为一个tick(10ms); 4层各256格, 第0层覆盖2.56s, 更远的定时器放在上层, 第0层转满一圈时逐层下放
+// 添加/取消O(1), 每个tick只处理当前格; 线程只在有定时器到期或需要下放时唤醒, 没有定时器时不唤醒
+// 回调在定时器线程中执行, 不能阻塞, 耗时的工作应投递到其他线程
+class TimerWheel {
+public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds TICK{10};
+    static constexpr int LEVEL_BITS = 8;
+    static constexpr size_t SLOTS = size_t{1} << LEVEL_BITS;
+    static constexpr size_t LEVELS = 4;
+
+    static TimerWheel& getInstance() {
+        static TimerWheel instance;
+        return instance;
+    }
+
+    ~TimerWheel();
+
+    // 单次定时器, delay后执行一次
+    TimerId schedule(std::chrono::milliseconds delay, Callback callback);
+    // 周期定时器, initial_delay后首次执行, 之后每interval执行一次(按计划时间, 不因回调耗时漂移)
+    TimerId schedulePeriodic(std::chrono::milliseconds interval, Callback callback,
+                             std::chrono::milliseconds initial_delay);
+    TimerId schedulePeriodic(std::chrono::milliseconds interval, Callback callback) {
+        return schedulePeriodic(interval, std::move(callback), interval);
+    }
+
+    // 取消定时器, 返回后回调不会再开始执行; 若回调正在其他线程执行则等待其结束,
+    // 调用方随后可以安全释放回调引用的对象. 在回调内部取消自身时不等待
+    // 定时器已触发完毕(单次)、已取消或id为0时返回false
+    bool cancel(TimerId id);
+
+    // 停止定时器线程并丢弃所有定时器, 之后的schedule返回0
+    void shutdown();
+
+    size_t size() const;
+
+private:
+    struct Timer {
+        TimerId id = 0;
+        uint64_t expiry = 0;    // 到期的tick
+        uint64_t interval = 0;  // 周期, tick数; 0表示单次
+        Callback callback;
+        Timer* prev = nullptr;
+        Timer* next = nullptr;
+    };
+
+    // 格内为侵入式双向链表, 取消时O(1)摘除; 哨兵节点的prev/next指向自身
+    struct Slot {
+        Timer head;
+        Slot() { head.prev = head.next = &head; }
+        bool empty() const { return head.next == &head; }
+    };
+
+    TimerWheel();
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    TimerId add(uint64_t delay_ticks, uint64_t interval_ticks, Callback callback);
+    void timerLoop();
+    // 以下调用方需持有mutex_
+    uint64_t nowTick() const;
+    void insertLocked(Timer* timer);
+    static void unlink(Timer* timer);
+    void cascadeLocked(size_t level);
+    void advanceLocked(uint64_t target, std::vector<TimerId>& expired);
+    // 下一次需要唤醒的tick, 没有定时器时为NO_WAKE
+    uint64_t nextWakeTickLocked() const;
+
+    static constexpr uint64_t NO_WAKE = UINT64_MAX;
+
+    const Clock::time_point epoch_;
+    uint64_t current_ = 0;  // 已处理到的tick
+    std::array<std::array<Slot, SLOTS>, LEVELS> wheels_;
+    std::unordered_map<TimerId, std::unique_ptr<Timer>> timers_;
+    TimerId next_id_ = 1;
+    uint64_t wake_tick_ = NO_WAKE;  // 定时器线程当前等待到的tick
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;         // 唤醒定时器线程
+    std::condition_variable running_cv_; // 回调执行完毕, 唤醒等待中的cancel
+    TimerId running_id_ = 0;             // 正在执行回调的定时器
+    bool running_cancelled_ = false;     // 正在执行的周期定时器已被取消, 执行完不再重排
+    bool stopped_ = false;
+    std::thread::id thread_id_;
+    std::thread thread_;
+};
+
+}  // namespace common
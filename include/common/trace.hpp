@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/trace_tag.hpp"
+
+namespace common {
+
+struct TraceOptions {
+    double sample_rate = 0.01;     // 采样比例, 按顺序每1/rate条消息采样一条; 0表示关闭
+    size_t buffer_capacity = 4096;  // 每个线程环形缓冲区保留的span数, 向上取整为2的幂
+};
+
+// 一个已结束的span
+struct TraceRecord {
+    const char* name = nullptr;  // 必须是字符串字面量
+    uint64_t trace_id = 0;
+    int64_t start_ns = 0;
+    int64_t end_ns = 0;
+};
+
+// 单线程写入的span环形缓冲区, 写满后覆盖最早的span
+// 导出线程并发读取: 每个槽位带序号, 读取前后序号一致且等于期望值才认为读到了完整的span
+class TraceBuffer {
+public:
+    TraceBuffer(size_t capacity, uint32_t tid, std::string thread_name);
+
+    // 只能由所属线程调用
+    void push(const TraceRecord& record);
+    // 读取当前保留的span, 按写入顺序
+    void snapshot(std::vector<TraceRecord>& records) const;
+
+    uint32_t tid() const;
+    std::string threadName() const;
+    // 线程退出后缓冲区交还Tracer, 由之后新建的线程复用, 保留的span直到被覆盖前仍可导出
+    void reassign(uint32_t tid, std::string thread_name);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};  // 写入完成后为写入序号+1, 写入中为0
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> trace_id{0};
+        std::atomic<int64_t> start_ns{0};
+        std::atomic<int64_t> end_ns{0};
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    std::atomic<uint64_t> head_{0};
+    mutable std::mutex name_mutex_;  // 仅保护tid_/thread_name_, 复用缓冲区时修改
+    uint32_t tid_;
+    std::string thread_name_;
+};
+
+// 端到端消息追踪
+// 在帧读取或定时请求处按采样比例决定是否追踪, 采样的消息分配追踪id并随消息传递;
+// 各线程在处理该消息期间通过TraceScope设置当前追踪id, X30_TRACE_SPAN据此记录span到本线程的环形缓冲区
+// 未采样时span只有一次thread_local读; 导出为Chrome/Perfetto可加载的trace JSON, 同一追踪id的span用flow事件串联
+class Tracer {
+public:
+    static Tracer& getInstance() {
+        static Tracer instance;
+        return instance;
+    }
+
+    // 需在任何线程记录span之前调用; sample_rate可随时通过setSampleRate修改
+    void configure(const TraceOptions& options);
+    void setSampleRate(double rate);
+    double sampleRate() const;
+
+    // 按采样比例返回新的追踪id, 未采样返回0
+    uint64_t sample();
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // 当前线程的追踪id, 由TraceScope设置
+    static uint64_t currentTraceId() {
+        return current_trace_id_;
+    }
+
+    // 记录一个已结束的span到当前线程的缓冲区, trace_id为0时忽略
+    void record(const char* name, uint64_t trace_id, int64_t start_ns, int64_t end_ns);
+
+    // 导出所有线程缓冲区中的span
+    std::string chromeTraceJson() const;
+    bool exportChromeTrace(const std::string& path) const;
+
+private:
+    friend class TraceScope;
+    struct ThreadHandle;
+
+    Tracer();
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    TraceBuffer& localBuffer();
+    void releaseBuffer(std::shared_ptr<TraceBuffer> buffer);
+
+    static thread_local uint64_t current_trace_id_;
+
+    std::atomic<uint64_t> sample_period_{0};  // 每多少条采样一条, 0表示关闭
+    std::atomic<uint64_t> sample_counter_{0};
+    std::atomic<uint64_t> next_trace_id_{0};
+    size_t buffer_capacity_ = 4096;
+    int64_t start_ns_;
+
+    mutable std::mutex mutex_;  // 保护buffers_和free_buffers_, 仅在线程首次记录和导出时使用
+    std::vector<std::shared_ptr<TraceBuffer>> buffers_;
+    std::vector<std::shared_ptr<TraceBuffer>> free_buffers_;
+};
+
+// 在作用域内设置当前线程的追踪id, 退出时恢复
+class TraceScope {
+public:
+    explicit TraceScope(uint64_t trace_id) : previous_(Tracer::current_trace_id_) {
+        Tracer::current_trace_id_ = trace_id;
+    }
+    ~TraceScope() {
+        Tracer::current_trace_id_ = previous_;
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    uint64_t previous_;
+};
+
+// 作用域span, 当前线程没有追踪id时不记录
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name) : name_(name), trace_id_(Tracer::currentTraceId()) {
+        if (trace_id_ != 0) {
+            start_ns_ = Tracer::now();
+        }
+    }
+    ~TraceSpan() {
+        if (trace_id_ != 0) {
+            Tracer::getInstance().record(name_, trace_id_, start_ns_, Tracer::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    uint64_t trace_id_;
+    int64_t start_ns_ = 0;
+};
+
+}  // namespace common
+
+#define X30_TRACE_CONCAT_INNER(a, b) a##b
+#define X30_TRACE_CONCAT(a, b) X30_TRACE_CONCAT_INNER(a, b)
+// 记录从此处到作用域结束的span, name必须是字符串字面量
+#define X30_TRACE_SPAN(name) ::common::TraceSpan X30_TRACE_CONCAT(x30_trace_span_, __LINE__)(name)
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace common {
+
+// 消息携带的追踪信息, 随消息跨线程传递; 单独成头文件, 协议层只依赖这个结构而不依赖追踪实现
+struct TraceTag {
+    uint64_t id = 0;         // 追踪id, 0表示未采样
+    int64_t queued_ns = 0;  // 进入消息队列的时间, 用于计算排队耗时
+};
+
+}  // namespace common
@@ -13,6 +13,9 @@ namespace common {
 // 辅助函数：获取当前时间戳
 std::string getCurrentTimestamp();
 
+// 辅助函数：获取config目录下配置文件的路径, config目录与可执行文件所在目录同级
+std::string getConfigPath(const std::string& fileName);
+
 std::vector<protocol::NavigationPoint> loadDefaultNavigationPoints(const std::string& configPath);
 
 // 辅助函数：加载默认导航点
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <boost/asio.hpp>
-#include <queue>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include "network/base_network_model.hpp"
+#include "network/outbound_queue.hpp"
 #include "protocol/protocol_header.hpp"
 
 namespace common {
@@ -19,10 +26,15 @@ public:
     void disconnect() override;
     bool isConnected() const override;
 
-    void sendMessage(const protocol::IMessage& message) override;
+    SendResult sendMessage(const protocol::IMessage& message) override;
 
 private:
-    bool doConnect(const boost::asio::ip::tcp::endpoint& endpoint);
+    struct ConnectRace;
+    // 对竞速中的下一个地址发起连接
+    void startAttempt(const std::shared_ptr<ConnectRace>& race);
+    void onAttemptComplete(const std::shared_ptr<ConnectRace>& race,
+                           const std::shared_ptr<boost::asio::ip::tcp::socket>& socket,
+                           const boost::asio::ip::tcp::endpoint& endpoint, const boost::system::error_code& error);
     void doRead();
     void doWrite();
     void handleRead(const boost::system::error_code& error, size_t bytes_transferred);
@@ -30,19 +42,33 @@ private:
     void processMessage(const std::vector<std::uint8_t>& message_data);
     void handleError(std::string_view error_msg);
 
-    // ASIO相关成员
+    // ASIO相关成员, work_需先于io_thread_构造, 避免run()因无任务立即返回
     boost::asio::io_context io_context_;
-    std::thread io_thread_;
     boost::asio::io_context::work work_;
+    std::thread io_thread_;
 
     boost::asio::ip::tcp::socket socket_;
     boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+    std::atomic<bool> connected_{false};
+
+    // 连接竞速(Happy Eyeballs)相关
+    std::atomic<bool> connecting_{false};
+    std::mutex race_mutex_;
+    std::shared_ptr<ConnectRace> current_race_;
 
     common::MessageQueue& message_queue_;
     boost::asio::streambuf read_buffer_;
-    std::queue<std::string> write_queue_;
+    // 断线期间不清空, 重连成功后继续发送
+    OutboundQueue write_queue_;
+    // 正在发送的消息, 写失败时保留以便重连后重发
+    std::string in_flight_;
+    uint64_t in_flight_trace_id_ = 0;   // in_flight_所属的追踪id, 0表示未采样
+    int64_t in_flight_popped_ns_ = 0;  // in_flight_开始发送的时间
+    protocol::MessageType in_flight_type_ = protocol::MessageType::PROCEDURE_RESET;  // in_flight_的消息类型
+    bool write_in_progress_ = false;
     std::mutex write_queue_mutex_;
     protocol::ProtocolHeader current_header_;
     std::vector<std::uint8_t> message_buffer_;
+    int64_t read_start_ns_ = 0;  // 当前帧开始读取的时间, 仅在strand_中访问
 };
 }  // namespace network
@@ -1,17 +1,110 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include "common/metrics.hpp"
+#include "network/traffic_recorder.hpp"
 #include "protocol/x30_protocol.hpp"
 
 namespace network {
 
+// 发送结果, 作为发送队列的背压信号
+enum class SendResult {
+    QUEUED,    // 已加入发送队列
+    REPLACED,  // 替换了队列中尚未发送的同类遥测请求
+    REJECTED,  // 所属优先级队列已满, 消息被丢弃
+};
+
+// 链路观察者, 由NetworkModelManager注入, 用于心跳检测等
+class ILinkObserver {
+public:
+    virtual ~ILinkObserver() = default;
+    virtual void onMessageSent(protocol::MessageType type) = 0;
+    virtual void onMessageReceived(protocol::MessageType type) = 0;
+};
+
 class BaseNetworkModel {
 public:
+    // 连接完成回调, 握手成功或所有地址均失败时在网络线程中调用, 不可阻塞
+    using ConnectCallback = std::function<void(bool connected)>;
+
     virtual ~BaseNetworkModel() = default;
+    // 发起异步连接, 返回false表示未能发起(如地址解析失败), 结果通过ConnectCallback通知
     virtual bool connect(const std::string& host, uint16_t port) = 0;
     virtual void disconnect() = 0;
     virtual bool isConnected() const = 0;
 
-    virtual void sendMessage(const protocol::IMessage& message) = 0;
+    virtual SendResult sendMessage(const protocol::IMessage& message) = 0;
+
+    // 当前连接的编号, 每次connect递增; 已被新连接替换的连接上报的错误编号更小
+    uint64_t connectionId() const {
+        return connection_id_.load(std::memory_order_acquire);
+    }
+
+    // 设置链路观察者, 需在connect之前调用
+    void setLinkObserver(std::shared_ptr<ILinkObserver> observer) {
+        link_observer_ = std::move(observer);
+    }
+
+    // 设置连接完成回调, 需在connect之前调用
+    void setConnectCallback(ConnectCallback callback) {
+        connect_callback_ = std::move(callback);
+    }
+
+    // 设置抓包记录器, 需在connect之前调用
+    void setTrafficRecorder(std::shared_ptr<TrafficRecorder> recorder) {
+        traffic_recorder_ = std::move(recorder);
+    }
+
+protected:
+    // connect发起新连接时调用
+    void beginConnection() {
+        connection_id_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void notifyConnectResult(bool connected) const {
+        if (connect_callback_) {
+            connect_callback_(connected);
+        }
+    }
+
+    void notifyMessageSent(protocol::MessageType type) const {
+        if (link_observer_) {
+            link_observer_->onMessageSent(type);
+        }
+    }
+
+    void notifyMessageReceived(protocol::MessageType type) const {
+        if (link_observer_) {
+            link_observer_->onMessageReceived(type);
+        }
+    }
+
+    // 每个完整收发的帧都经过这里: 计入帧数和字节数指标, 开启抓包时写入抓包文件
+    void recordFrame(CaptureDirection direction, const void* head, size_t head_size, const void* body = nullptr,
+                     size_t body_size = 0) const {
+        static auto& registry = common::MetricsRegistry::getInstance();
+        static auto& frames_in = registry.counter("x30_frames_total", "收发的完整帧数", "direction=\"in\"");
+        static auto& frames_out = registry.counter("x30_frames_total", "收发的完整帧数", "direction=\"out\"");
+        static auto& bytes_in = registry.counter("x30_frame_bytes_total", "收发的帧字节数, 含协议头", "direction=\"in\"");
+        static auto& bytes_out =
+            registry.counter("x30_frame_bytes_total", "收发的帧字节数, 含协议头", "direction=\"out\"");
+        bool inbound = direction == CaptureDirection::INBOUND;
+        (inbound ? frames_in : frames_out).inc();
+        (inbound ? bytes_in : bytes_out).inc(head_size + body_size);
+
+        if (traffic_recorder_) {
+            traffic_recorder_->record(direction, head, head_size, body, body_size);
+        }
+    }
+
+private:
+    std::shared_ptr<ILinkObserver> link_observer_;
+    std::shared_ptr<TrafficRecorder> traffic_recorder_;
+    ConnectCallback connect_callback_;
+    std::atomic<uint64_t> connection_id_{0};
 };
 }  // namespace network
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <sys/epoll.h>
+#include <sys/socket.h>
 #include <atomic>
+#include <chrono>
 #include <mutex>
-#include <queue>
+#include <string>
 #include <thread>
+#include <vector>
+#include "common/stop_token.hpp"
 #include "network/base_network_model.hpp"
+#include "network/outbound_queue.hpp"
 
 namespace common {
 class MessageQueue;
@@ -21,7 +26,7 @@ public:
     bool connect(const std::string& host, uint16_t port) override;
     void disconnect() override;
     bool isConnected() const override;
-    void sendMessage(const protocol::IMessage& message) override;
+    SendResult sendMessage(const protocol::IMessage& message) override;
 
 private:
     // 初始化epoll
@@ -34,21 +39,60 @@ private:
     bool handleRead();
     // 处理写事件
     bool handleWrite();
+    // 从发送队列取出下一条消息作为in_flight_, 调用方需持有write_mutex_
+    bool popInFlight();
     // 设置非阻塞
     void setNonBlocking(int fd);
+    // 更新socket关注的epoll事件, 调用方需持有write_mutex_
+    bool updateEpollEvents(bool want_write);
+    // 关闭socket与epoll句柄, 保留发送队列以便重连后继续发送
+    void closeSocket();
+
+    // 地址解析结果
+    struct Endpoint {
+        sockaddr_storage addr;
+        socklen_t len;
+    };
+    // 解析host的全部IPv4/IPv6地址, 按地址族交替排序
+    static std::vector<Endpoint> resolveEndpoints(const std::string& host, uint16_t port);
+    // 对下一个地址发起非阻塞连接
+    void startNextAttempt();
+    // 处理连接尝试的完成事件(EPOLLOUT/EPOLLERR)
+    void handleConnectEvent(int fd);
+    // 采用竞速胜出的socket, 关闭其余连接尝试
+    bool adoptSocket(int fd);
+    void closeAttempts();
+    // 检查竞速是否需要启动下一个地址或已全部失败
+    void checkConnectProgress();
 
 private:
     void handleError(std::string_view error_msg);
 
     std::thread event_thread_;
     std::atomic<bool> running_;
+    // disconnect时唤醒阻塞在epoll_wait中的事件线程
+    common::StopToken stop_;
 
     common::MessageQueue& message_queue_;
     int epoll_fd_;
     int socket_fd_;
     std::atomic<bool> connected_;
 
-    std::queue<std::string> write_queue_;
+    // 连接竞速(Happy Eyeballs)相关, 连接建立前仅在事件线程中访问
+    std::atomic<bool> connecting_;
+    std::vector<Endpoint> pending_endpoints_;
+    std::vector<int> attempt_fds_;
+    std::chrono::steady_clock::time_point next_attempt_at_;
+    std::chrono::steady_clock::time_point connect_deadline_;
+
+    // 断线期间不清空, 重连成功后继续发送
+    OutboundQueue write_queue_;
+    // 正在发送的消息及已写出的字节数, 写完之前不会被更高优先级消息打断
+    std::string in_flight_;
+    size_t write_offset_;
+    uint64_t in_flight_trace_id_ = 0;   // in_flight_所属的追踪id, 0表示未采样
+    int64_t in_flight_popped_ns_ = 0;  // in_flight_开始发送的时间
+    protocol::MessageType in_flight_type_ = protocol::MessageType::PROCEDURE_RESET;  // in_flight_的消息类型
     std::mutex write_mutex_;
 };
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "common/timer_wheel.hpp"
+#include "network/base_network_model.hpp"
+
+namespace network {
+
+// 心跳策略
+struct HeartbeatPolicy {
+    std::chrono::milliseconds probe_interval{1000};   // 空闲时探测间隔, 任务期间复用定时1007
+    std::chrono::milliseconds initial_timeout{3000};  // 尚无RTT样本时的超时时间
+    std::chrono::milliseconds min_timeout{1000};      // 超时下限
+    std::chrono::milliseconds max_timeout{10000};     // 超时上限
+    double rto_multiplier = 3.0;                      // 超时时间 = RTO * rto_multiplier
+};
+
+// 应用层心跳检测
+// 以1007/2007作为探测报文, 按RFC 6298维护平滑RTT(SRTT)与RTT方差(RTTVAR),
+// 探测在自适应超时时间内未得到响应即判定链路失效, 用于发现半开连接
+// 检测由共享时间轮周期触发, 不占用独立线程
+class HeartbeatMonitor : public ILinkObserver {
+public:
+    using ProbeSender = std::function<void()>;
+    using DeadHandler = std::function<void(const std::string&)>;
+
+    HeartbeatMonitor(HeartbeatPolicy policy, ProbeSender probe_sender, DeadHandler dead_handler);
+    ~HeartbeatMonitor() override;
+
+    void start();
+    void stop();
+
+    // 链路建立时重置RTT估计, 链路断开时暂停检测
+    void onConnected();
+    void onDisconnected();
+
+    void onMessageSent(protocol::MessageType type) override;
+    void onMessageReceived(protocol::MessageType type) override;
+
+    // 当前平滑RTT与方差, 单位毫秒
+    double srtt() const;
+    double rttvar() const;
+    // 当前判定链路失效的超时时间
+    std::chrono::milliseconds timeout() const;
+
+private:
+    void tick();
+    void updateRtt(double sample_ms);
+    std::chrono::milliseconds timeoutLocked() const;
+
+    HeartbeatPolicy policy_;
+    ProbeSender probe_sender_;
+    DeadHandler dead_handler_;
+
+    mutable std::mutex mutex_;
+    common::TimerWheel::TimerId tick_timer_ = 0;
+    bool link_up_ = false;
+
+    // RTT估计, 未采样前srtt_为负
+    double srtt_ = -1.0;
+    double rttvar_ = 0.0;
+
+    // 未响应的探测数量及第一个未响应探测的发送时间
+    int outstanding_probes_ = 0;
+    std::chrono::steady_clock::time_point probe_sent_at_;
+    std::chrono::steady_clock::time_point last_probe_at_;
+};
+
+}  // namespace network
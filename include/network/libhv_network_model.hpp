@@ -15,6 +15,7 @@ public:
     ~LibhvNetworkModel() override = default;
 
     bool connect(const std::string&, uint16_t) override {
+        notifyConnectResult(true);
         return true;
     }
     void disconnect() override {
@@ -23,7 +24,8 @@ public:
         return true;
     }
 
-    void sendMessage(const protocol::IMessage&) override {
+    SendResult sendMessage(const protocol::IMessage&) override {
+        return SendResult::QUEUED;
     }
 };
 }  // namespace network
@@ -1,15 +1,39 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include "common/event_bus.hpp"
 #include "common/message_queue.hpp"
+#include "network/heartbeat_monitor.hpp"
 #include "network/i_network_model_manager.hpp"
 #include "network/network_model_factory.hpp"
+#include "network/traffic_recorder.hpp"
 
 namespace network {
 
+// 断线重连策略: 带抖动的指数退避
+struct ReconnectPolicy {
+    std::chrono::milliseconds initial_delay{50};  // 首次重连延迟
+    std::chrono::milliseconds max_delay{5000};    // 最大重连延迟
+    double multiplier = 2.0;                      // 退避倍数
+    double jitter = 0.5;                          // 抖动比例, 实际延迟在[delay*(1-jitter), delay]之间
+    int max_attempts = 0;                         // 最大连续重连次数, 0表示不限制
+    // 连接保持超过该时长才视为稳定, 再次断线时退避从头开始
+    std::chrono::milliseconds stable_period{10000};
+};
+
 // 通信管理器
 class NetworkModelManager : public INetworkModelManager {
 public:
-    explicit NetworkModelManager(network::NetworkModelType model_type, common::MessageQueue& message_queue);
+    explicit NetworkModelManager(network::NetworkModelType model_type, common::MessageQueue& message_queue,
+                                 ReconnectPolicy policy = ReconnectPolicy{},
+                                 HeartbeatPolicy heartbeat_policy = HeartbeatPolicy{});
     ~NetworkModelManager() override;
 
     // 启动和停止
@@ -19,10 +43,54 @@ public:
     // 获取网络模型实例
     std::shared_ptr<BaseNetworkModel> getNetworkModel() override;
 
+    // 设置抓包记录器, 需在start之前调用, 重连后继续写入同一文件
+    void setTrafficRecorder(std::shared_ptr<TrafficRecorder> recorder);
+
 private:
+    // 发起连接并等待握手完成或失败, 连接成功返回true
+    bool connectAndWait();
+    // 网络模型的连接完成回调
+    void onConnectResult(bool connected);
+    // 重连线程函数
+    void reconnectLoop();
+    // 计算第attempt次重连前的等待时间
+    std::chrono::milliseconds nextDelay(int attempt);
+    // 网络错误回调, 仅唤醒重连线程; 已被重连替换或已处理过的连接上报的错误被忽略
+    // heartbeat_reason非空表示由心跳判定失效, 只有断线被接受时才记录, 由重连线程发布NetworkErrorEvent
+    void onLinkLost(uint64_t connection_id, const std::string& heartbeat_reason = {});
+    // 心跳探测与失效处理, 在共享定时器线程中调用, 只记录断线, 断开和通知由重连线程完成
+    void sendProbe();
+    void onHeartbeatTimeout(const std::string& reason);
+
     network::NetworkModelType model_type_;
     std::shared_ptr<BaseNetworkModel> network_model_;
     common::MessageQueue& message_queue_;
+
+    // 断线重连相关
+    ReconnectPolicy policy_;
+    std::string host_;
+    uint16_t port_ = 0;
+    common::EventBus::HandlerId error_handler_id_ = common::EventBus::INVALID_HANDLER_ID;
+    std::thread reconnect_thread_;
+    std::mutex reconnect_mutex_;
+    std::condition_variable reconnect_cv_;
+    bool link_lost_ = false;
+    uint64_t lost_connection_id_ = 0;  // 最近一次已处理断线的连接编号
+    std::string heartbeat_loss_reason_;  // 心跳判定失效的原因, 由重连线程发布NetworkErrorEvent后清空
+    bool stopping_ = false;
+    int attempts_ = 0;
+    std::chrono::steady_clock::time_point connected_at_;
+
+    // 当前连接尝试的结果
+    std::mutex connect_mutex_;
+    std::optional<std::promise<bool>> connect_promise_;
+    std::mt19937 rng_{std::random_device{}()};
+
+    // 心跳检测
+    std::shared_ptr<HeartbeatMonitor> heartbeat_monitor_;
+
+    // 抓包记录, 为空表示不抓包
+    std::shared_ptr<TrafficRecorder> traffic_recorder_;
 };
 
 }  // namespace network
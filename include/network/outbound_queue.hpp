@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include "network/base_network_model.hpp"
+
+namespace network {
+
+// 发送优先级, 数值越小越优先
+enum class SendPriority {
+    CONTROL = 0,    // 控制类: 1004取消任务
+    MISSION = 1,    // 任务类: 1003导航任务
+    TELEMETRY = 2,  // 遥测轮询: 1002/1007
+};
+
+// 分优先级、有界的发送队列
+// 1. 高优先级消息总是先于低优先级消息发送, 保证取消任务的时延不受遥测积压影响
+// 2. 每个优先级独立限长, 对端停滞时内存占用有上限
+// 3. 同类遥测请求在队列中只保留最新一条
+// 非线程安全, 由网络模型持锁访问
+class OutboundQueue {
+public:
+    explicit OutboundQueue(size_t control_capacity = 16, size_t mission_capacity = 4, size_t telemetry_capacity = 8);
+
+    static SendPriority classify(protocol::MessageType type);
+
+    // trace_id为消息所属的追踪id, 随消息一起取出, 用于记录发送span
+    SendResult push(protocol::MessageType type, std::string frame, uint64_t trace_id = 0);
+    // 取出优先级最高的消息, 队列为空时返回false
+    bool pop(std::string& frame);
+    // 同时取出消息类型和追踪id, 写完后按实际发出的类型通知链路观察者
+    bool pop(std::string& frame, uint64_t& trace_id, protocol::MessageType& type);
+
+    bool empty() const;
+    size_t size() const;
+
+private:
+    struct Entry {
+        protocol::MessageType type;
+        std::string frame;
+        uint64_t trace_id;
+    };
+
+    static constexpr size_t PRIORITY_COUNT = 3;
+    std::array<std::deque<Entry>, PRIORITY_COUNT> lanes_;
+    std::array<size_t, PRIORITY_COUNT> capacities_;
+};
+
+}  // namespace network
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace network {
+
+// 抓包文件格式:
+// 文件头(CaptureFileHeader) + 若干条记录(CaptureRecordHeader + 原始帧)
+// 原始帧包含16字节协议头和消息体, 记录按写入顺序排列, length为0表示结束
+#pragma pack(push, 1)
+struct CaptureFileHeader {
+    char magic[8];             // "X30CAP01"
+    uint64_t start_wall_ns;    // 抓包开始时的系统时间, 纳秒
+    uint32_t version;          // 格式版本
+    uint32_t reserved;
+};
+
+struct CaptureRecordHeader {
+    uint64_t timestamp_ns;  // 相对抓包开始的单调时间, 纳秒
+    uint32_t length;        // 帧长度
+    uint8_t direction;      // CaptureDirection
+    uint8_t reserved[3];
+};
+#pragma pack(pop)
+
+enum class CaptureDirection : uint8_t {
+    INBOUND = 0,   // 设备 -> 本机
+    OUTBOUND = 1,  // 本机 -> 设备
+};
+
+// 网络流量抓包
+// 以内存映射文件追加记录收发的原始帧, 写入只涉及一次内存拷贝, 用于离线复现现场问题和回放压测
+class TrafficRecorder {
+public:
+    static constexpr char MAGIC[8] = {'X', '3', '0', 'C', 'A', 'P', '0', '1'};
+    static constexpr uint32_t VERSION = 1;
+
+    explicit TrafficRecorder(std::string path);
+    ~TrafficRecorder();
+
+    TrafficRecorder(const TrafficRecorder&) = delete;
+    TrafficRecorder& operator=(const TrafficRecorder&) = delete;
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    // 记录一帧, 帧可由协议头和消息体两段组成
+    void record(CaptureDirection direction, const void* head, size_t head_size, const void* body = nullptr,
+                size_t body_size = 0);
+
+private:
+    // 映射区不足时扩大文件并重新映射, 调用方需持有mutex_
+    bool ensureCapacity(size_t required);
+
+    std::string path_;
+    std::mutex mutex_;
+    int fd_ = -1;
+    uint8_t* data_ = nullptr;
+    size_t capacity_ = 0;
+    size_t offset_ = 0;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace network
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "network/traffic_recorder.hpp"
+
+namespace common {
+class MessageQueue;
+}  // namespace common
+
+namespace network {
+
+// 抓包文件中的一帧
+struct CapturedFrame {
+    uint64_t timestamp_ns;
+    CaptureDirection direction;
+    std::string_view data;  // 指向映射区, 生命周期与TrafficReplayer相同
+};
+
+// 回放统计
+struct ReplayStats {
+    size_t frames = 0;         // 回放的入站帧数
+    size_t bytes = 0;          // 回放的入站字节数
+    size_t parse_failures = 0;  // 解析失败的帧数
+    double elapsed_ms = 0.0;   // 回放耗时
+};
+
+// 抓包回放
+// 按原速、倍速或最快速度将抓包中的入站帧送入MessageFactory和MessageQueue
+class TrafficReplayer {
+public:
+    explicit TrafficReplayer(std::string path);
+    ~TrafficReplayer();
+
+    TrafficReplayer(const TrafficReplayer&) = delete;
+    TrafficReplayer& operator=(const TrafficReplayer&) = delete;
+
+    bool open();
+    const std::vector<CapturedFrame>& frames() const;
+
+    // speed为回放倍速, 1.0为原速, 小于等于0表示不等待, 以最快速度回放
+    ReplayStats replay(common::MessageQueue& message_queue, double speed) const;
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<CapturedFrame> frames_;
+};
+
+}  // namespace network
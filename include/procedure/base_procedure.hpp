@@ -10,6 +10,10 @@ public:
     virtual ~BaseProcedure() = default;
     virtual void start() = 0;
     virtual void process_event(const protocol::IMessage& message) = 0;
+    // 过程已进入终止状态, 等待消息处理线程重置
+    virtual bool finished() const {
+        return false;
+    }
 };
 
 }  // namespace procedure
@@ -1,8 +1,9 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <memory>
-#include <thread>
+#include "common/timer_wheel.hpp"
 #include "procedure/base_procedure.hpp"
 #include "state/nav/nav_machine.hpp"
 
@@ -15,18 +16,21 @@ public:
 
     void start() override;
     void process_event(const protocol::IMessage& message) override;
+    bool finished() const override {
+        return finished_;
+    }
 
 private:
-    void statusQueryLoop();
+    void sendStatusQuery();
     void startStatusQuery();
     void stopStatusQuery();
 
     std::unique_ptr<state::NavigationMachine> state_machine_;
+    bool finished_ = false;  // 仅在消息处理线程中读写
 
-    // 定时1007状态查询相关
-    std::atomic<bool> status_query_running_{false};
-    std::thread status_query_thread_;
-    static constexpr int STATUS_QUERY_INTERVAL_MS = 1000;
+    // 定时1007状态查询, 由共享时间轮触发
+    std::atomic<common::TimerWheel::TimerId> status_query_timer_{0};
+    static constexpr std::chrono::milliseconds STATUS_QUERY_INTERVAL{1000};
 };
 
 }  // namespace procedure
@@ -5,6 +5,7 @@
 #include <rapidxml/rapidxml.hpp>
 #include <string>
 #include <vector>
+#include "common/trace_tag.hpp"
 
 namespace protocol {
 
@@ -88,9 +89,22 @@ public:
 
     virtual bool deserialize(const std::string& xml) = 0;
     virtual MessageType getType() const = 0;
+    // 估算消息占用的内存字节数, 用于消息队列的内存预算
+    virtual size_t memoryUsage() const = 0;
+
+    // 入站消息的追踪信息, 由网络线程在解码后设置, 消息处理线程据此延续同一条追踪
+    const common::TraceTag& traceTag() const {
+        return trace_tag_;
+    }
+    void setTraceTag(const common::TraceTag& tag) {
+        trace_tag_ = tag;
+    }
 
 protected:
     virtual std::string serializeToXml() const = 0;
+
+private:
+    common::TraceTag trace_tag_;
 };
 
 // =============== 请求消息定义 ===============
@@ -103,6 +117,9 @@ public:
     MessageType getType() const override {
         return MessageType::GET_REAL_TIME_STATUS_REQ;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this) + timestamp.capacity();
+    }
     std::string serializeToXml() const override;
     bool deserialize(const std::string& xml) override;
 
@@ -114,6 +131,9 @@ public:
     MessageType getType() const override {
         return MessageType::NAVIGATION_TASK_REQ;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this) + points.capacity() * sizeof(NavigationPoint) + timestamp.capacity();
+    }
     std::string serializeToXml() const override;
     bool deserialize(const std::string& xml) override;
 
@@ -127,6 +147,9 @@ public:
     MessageType getType() const override {
         return MessageType::CANCEL_TASK_REQ;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this) + timestamp.capacity();
+    }
     std::string serializeToXml() const override;
     bool deserialize(const std::string& xml) override;
 
@@ -139,6 +162,9 @@ public:
     MessageType getType() const override {
         return MessageType::QUERY_STATUS_REQ;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this) + timestamp.capacity();
+    }
     std::string serializeToXml() const override;
     bool deserialize(const std::string& xml) override;
 
@@ -153,6 +179,9 @@ public:
     MessageType getType() const override {
         return MessageType::GET_REAL_TIME_STATUS_RESP;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this) + timestamp.capacity();
+    }
     std::string serializeToXml() const override;
     bool deserialize(const std::string& xml) override;
 
@@ -192,6 +221,9 @@ public:
     MessageType getType() const override {
         return MessageType::NAVIGATION_TASK_RESP;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this) + timestamp.capacity();
+    }
     std::string serializeToXml() const override;
     bool deserialize(const std::string& xml) override;
 
@@ -207,6 +239,9 @@ public:
     MessageType getType() const override {
         return MessageType::CANCEL_TASK_RESP;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this) + timestamp.capacity();
+    }
     std::string serializeToXml() const override;
     bool deserialize(const std::string& xml) override;
 
@@ -220,6 +255,9 @@ public:
     MessageType getType() const override {
         return MessageType::QUERY_STATUS_RESP;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this) + timestamp.capacity();
+    }
     std::string serializeToXml() const override;
     bool deserialize(const std::string& xml) override;
 
@@ -236,6 +274,9 @@ public:
     MessageType getType() const override {
         return MessageType::PROCEDURE_RESET;
     }
+    size_t memoryUsage() const override {
+        return sizeof(*this);
+    }
     std::string serializeToXml() const override {
         return "";
     };
@@ -2,16 +2,22 @@
 
 #include <boost/mpl/vector.hpp>
 #include <boost/msm/front/state_machine_def.hpp>
+#include <chrono>
 #include <iostream>
 // #include <fmt/core.h>
 // #include "common/logger.hpp"
 #include <spdlog/spdlog.h>
+#include "common/metrics.hpp"
+#include "common/probes.hpp"
 #include "common/utils.hpp"
 // 定义 BaseState
 template <typename Derived>
 struct BaseState : public boost::msm::front::state<> {
     template <class Event, class FSM>
     void on_entry(Event const&, FSM&) {
+        stateMetrics().entries.inc();
+        entered_at_ = std::chrono::steady_clock::now();
+        X30_PROBE1(state_entry, static_cast<Derived*>(this)->get_state_name());
         spdlog::info("[{}]: [NavFsm:State]: 进入{}状态", common::getCurrentTimestamp(),
                      static_cast<Derived*>(this)->get_state_name());
         // std::cout << fmt::format("[{}]: [NavFsm:State]: 进入{}状态", common::getCurrentTimestamp(), static_cast<Derived*>(this)->get_state_name()) << std::endl;
@@ -20,6 +26,11 @@ struct BaseState : public boost::msm::front::state<> {
 
     template <class Event, class FSM>
     void on_exit(Event const&, FSM&) {
+        auto duration_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - entered_at_)
+                .count());
+        stateMetrics().duration.record(duration_ns);
+        X30_PROBE2(state_exit, static_cast<Derived*>(this)->get_state_name(), duration_ns);
         spdlog::info("[{}]: [NavFsm:State]: 退出{}状态", common::getCurrentTimestamp(),
                      static_cast<Derived*>(this)->get_state_name());
         // std::cout << fmt::format("[{}]: [NavFsm:State]: 退出{}状态", common::getCurrentTimestamp(), static_cast<Derived*>(this)->get_state_name()) << std::endl;
@@ -30,4 +41,23 @@ struct BaseState : public boost::msm::front::state<> {
     // virtual void do_on_entry() = 0;
     // virtual void do_on_exit() = 0;
     virtual const char* get_state_name() const = 0;
+
+private:
+    struct StateMetrics {
+        common::Counter& entries;
+        common::Histogram& duration;
+    };
+
+    // 每个状态类型一组指标, 以状态名为标签
+    StateMetrics& stateMetrics() const {
+        static StateMetrics metrics = [this] {
+            auto labels = std::string("state=\"") + get_state_name() + "\"";
+            auto& registry = common::MetricsRegistry::getInstance();
+            return StateMetrics{registry.counter("x30_nav_state_entries_total", "进入导航状态的次数", labels),
+                                registry.histogram("x30_nav_state_duration_ns", "导航状态停留时长, 纳秒", labels)};
+        }();
+        return metrics;
+    }
+
+    std::chrono::steady_clock::time_point entered_at_;
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <initializer_list>
 #include "network/base_network_model.hpp"
 
 namespace common {
@@ -7,6 +8,11 @@ class MessageQueue;
 }  // namespace common
 
 namespace state {
+// 导航过程的任务响应, 过程结束后残留的这些响应不再处理
+inline constexpr std::initializer_list<protocol::MessageType> NAV_TASK_RESPONSES = {
+    protocol::MessageType::NAVIGATION_TASK_RESP, protocol::MessageType::CANCEL_TASK_RESP,
+    protocol::MessageType::QUERY_STATUS_RESP};
+
 // 导航上下文
 struct NavigationContext {
     // MessageQueue保持依赖注入
@@ -17,6 +17,7 @@
 #include "state/nav/nav_states.hpp"
 // #include <fmt/core.h>
 #include <spdlog/spdlog.h>
+#include "common/log_sampler.hpp"
 #include "common/utils.hpp"
 
 namespace state {
@@ -74,7 +75,8 @@ struct NavigationMachine_ : public boost::msm::front::state_machine_def<Navigati
     // 处理未定义的转换
     template <class FSM, class Event>
     void no_transition(Event const&, FSM&, int state) {
-        spdlog::warn("[{}]: [NavFsm:WRN]: 无法处理当前状态({})下的事件", common::getCurrentTimestamp(), state);
+        X30_LOG_SAMPLED("NavFsm:未定义转换", 1.0, 5, spdlog::level::warn,
+                        "[{}]: [NavFsm:WRN]: 无法处理当前状态({})下的事件", common::getCurrentTimestamp(), state);
         // std::cout << fmt::format("[{}]: [NavFsm:WRN]: 无法处理当前状态({})下的事件", common::getCurrentTimestamp(), state) << std::endl;
     }
 
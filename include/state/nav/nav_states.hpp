@@ -5,6 +5,7 @@
 #include "common/utils.hpp"
 #include "protocol/x30_protocol.hpp"
 #include "state/base_state.hpp"
+#include "state/nav/nav_context.hpp"
 // #include <fmt/core.h>
 #include <spdlog/spdlog.h>
 namespace state {
@@ -43,7 +44,8 @@ struct Done : public boost::msm::front::terminate_state<> {
     void on_entry(Event const&, FSM& fsm) {
         spdlog::info("[{}]: [NavFsm:State]: 进入结束状态", common::getCurrentTimestamp());
         // std::cout << fmt::format("[{}]: [NavFsm:State]: 进入结束状态", common::getCurrentTimestamp()) << std::endl;
-        fsm.context_.message_queue.clear();
+        // 丢弃本次导航过程残留的任务响应, 保留用户命令和遥测
+        fsm.context_.message_queue.purge(NAV_TASK_RESPONSES);
         fsm.context_.message_queue.push(std::make_unique<protocol::ProcedureReset>());
         fsm.on_terminate();
     }
@@ -1,6 +1,12 @@
 #include "application/x30_inspection_system.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include "common/binary_log.hpp"
 #include "common/event_bus.hpp"
+#include "common/metrics.hpp"
+#include "common/thread_config.hpp"
+#include "common/trace.hpp"
 #include "common/utils.hpp"
 #include "network/network_model_manager.hpp"
 #include "procedure/nav_procedure/nav_procedure.hpp"
@@ -13,33 +19,53 @@
 
 namespace {
 std::unordered_map<int, protocol::NavigationPoint> point_map_ = common::loadNavigationPointsMap();
+
+// 消息处理线程每次唤醒最多处理的消息条数
+constexpr size_t MAX_BATCH_SIZE = 64;
+
+// 只有最新的实时状态有意义, 处理线程落后时合并遥测, 避免过期位姿堆积
+// 状态机卡住时入站消息不能无限增长, 超出预算先丢弃最早的遥测
+common::MessageQueueOptions messageQueueOptions() {
+    common::MessageQueueOptions options;
+    options.conflate_telemetry = true;
+    options.max_messages = 10000;
+    options.max_bytes = 16 * 1024 * 1024;
+    options.overflow_policy = common::OverflowPolicy::DROP_OLDEST_TELEMETRY;
+    options.name = "messages";
+    return options;
+}
 }  // namespace
 namespace application {
-X30InspectionSystem::X30InspectionSystem() : message_queue_running_(false) {
+X30InspectionSystem::X30InspectionSystem() : message_queue_(messageQueueOptions()), message_queue_running_(false) {
 }
 
 X30InspectionSystem::~X30InspectionSystem() {
     shutdown();
 }
 
-bool X30InspectionSystem::initialize(const std::string& host, uint16_t port) {
-    // 订阅网络错误事件
-    common::EventBus::getInstance().subscribe<common::NetworkErrorEvent>([this](const std::shared_ptr<common::Event>&) {
-        // 网络错误关闭连接
-        if (network_model_manager_) {
-            if (auto network_model = network_model_manager_->getNetworkModel(); network_model) {
-                network_model->disconnect();
-            }
-        }
+bool X30InspectionSystem::initialize(const std::string& host, uint16_t port, const std::string& capture_path) {
+    // 事件在重连线程中发布, 这里不直接访问nav_state_procedure_, 它只属于消息处理线程
+    // 订阅网络重连成功事件, 重新查询任务状态以恢复导航过程
+    event_handler_ids_.push_back(common::EventBus::getInstance().subscribe<common::NetworkReconnectedEvent>(
+        [this](const common::NetworkReconnectedEvent&) { resumeNavProcedure(); }));
 
-        if (nav_state_procedure_) {
-            nav_state_procedure_.reset();
-        }
-    });
+    // 订阅网络重连失败事件, 重连耗尽后结束导航过程, 由消息处理线程执行重置
+    event_handler_ids_.push_back(common::EventBus::getInstance().subscribe<common::NetworkReconnectFailedEvent>(
+        [this](const common::NetworkReconnectFailedEvent&) {
+            message_queue_.push(std::make_unique<protocol::ProcedureReset>());
+        }));
 
     // 初始化通信管理器
     network_model_manager_ =
         std::make_unique<network::NetworkModelManager>(network::NetworkModelType::EPOLL, message_queue_);
+    if (!capture_path.empty()) {
+        auto recorder = std::make_shared<network::TrafficRecorder>(capture_path);
+        if (!recorder->open()) {
+            return false;
+        }
+        spdlog::info("[{}]: [X30InspectionSystem:INFO]: 抓包已开启: {}", common::getCurrentTimestamp(), capture_path);
+        network_model_manager_->setTrafficRecorder(std::move(recorder));
+    }
     if (!network_model_manager_->start(host, port)) {
         return false;
     }
@@ -52,29 +78,47 @@ bool X30InspectionSystem::initialize(const std::string& host, uint16_t port) {
 }
 
 void X30InspectionSystem::shutdown() {
+    // 析构时会再次调用, 只执行一次
+    if (shutdown_done_.exchange(true)) {
+        return;
+    }
     try {
         spdlog::info("[{}]: [X30InspectionSystem:INFO]: 系统关闭", common::getCurrentTimestamp());
-        // 1.先停止导航程序
-        if (nav_state_procedure_) {
-            nav_state_procedure_.reset();
+        auto start = std::chrono::steady_clock::now();
+
+        // 1. 取消事件订阅, 之后不会再有其他线程回调进来
+        for (auto id : event_handler_ids_) {
+            common::EventBus::getInstance().unsubscribe(id);
         }
+        event_handler_ids_.clear();
 
-        // 2. 停止网络
+        // 2. 停止网络: 心跳定时器、重连线程、事件线程依次退出, 不再有消息入队
         if (network_model_manager_) {
-            // network_model_manager_->getNetworkModel()->disconnect();
             network_model_manager_->stop();
-            network_model_manager_.reset();
         }
 
-        // 3. 停止消息处理线程
+        // 3. 停止消息处理线程, close唤醒阻塞中的drain
         message_queue_running_ = false;
         message_queue_.close();
         if (message_thread_.joinable()) {
             message_thread_.join();
         }
 
-        // 4. 清理资源
-        // network_model_manager_.reset();
+        // 4. 消息处理线程已退出, 导航过程不再被并发访问, 释放时取消定时1007
+        nav_state_procedure_.reset();
+
+        // 5. 释放网络资源
+        network_model_manager_.reset();
+
+        auto stats = message_queue_.stats();
+        spdlog::info(
+            "[{}]: [X30InspectionSystem:INFO]: 消息队列统计: 峰值 {} 条/{} 字节, 合并遥测 {} 条, 丢弃遥测 {} 条, "
+            "拒绝 {} 条, 阻塞 {} 次",
+            common::getCurrentTimestamp(), stats.high_water_messages, stats.high_water_bytes, stats.superseded,
+            stats.dropped_telemetry, stats.rejected, stats.blocked);
+        spdlog::info("[{}]: [X30InspectionSystem:INFO]: 系统关闭完成, 耗时 {}ms", common::getCurrentTimestamp(),
+                     std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)
+                         .count());
     }
     catch (const std::exception& e) {
         std::cerr << "系统关闭异常: " << e.what() << std::endl;
@@ -104,8 +148,8 @@ bool X30InspectionSystem::startInspection() {
         nav_state_procedure_->start();
 
         spdlog::info("[{}]: 导航任务执行状态: 已启动", common::getCurrentTimestamp());
-        std::shared_ptr<common::NavigationTaskEvent> event = std::make_shared<common::NavigationTaskEvent>();
-        event->status = "已启动";
+        common::NavigationTaskEvent event;
+        event.status = "已启动";
         common::EventBus::getInstance().publish(event);
 
         return true;
@@ -122,7 +166,10 @@ bool X30InspectionSystem::cancelInspection() {
     if (nav_state_procedure_) {
         protocol::CancelTaskRequest request;
         request.timestamp = common::getCurrentTimestamp();
-        network_model_manager_->getNetworkModel()->sendMessage(request);
+        if (network_model_manager_->getNetworkModel()->sendMessage(request) == network::SendResult::REJECTED) {
+            handleError("Command: cancel: 执行失败，发送队列已满");
+            return false;
+        }
         spdlog::info("[{}]: [X30InspectionSystem:INFO]: 用户触发发送1004 Request", request.timestamp);
         // std::cout << fmt::format("[{}]: 用户触发发送1004 Request", request.timestamp) << std::endl;
         return true;
@@ -148,113 +195,180 @@ bool X30InspectionSystem::queryStatus() {
     return false;
 }
 
+void X30InspectionSystem::resumeNavProcedure() {
+    // 断线期间可能错过状态变化, 立即发送1007查询当前任务状态, 由状态机继续推进
+    // 在重连线程中调用, 不检查nav_state_procedure_: 没有导航任务时2007响应按空闲心跳处理, 不影响状态
+    protocol::QueryStatusRequest request;
+    request.timestamp = common::getCurrentTimestamp();
+    network_model_manager_->getNetworkModel()->sendMessage(request);
+    spdlog::info("[{}]: [X30InspectionSystem:INFO]: 网络已恢复, 发送1007 Request恢复导航任务", request.timestamp);
+}
+
 void X30InspectionSystem::resetNavProcedure() {
     nav_state_procedure_.reset();
+    // 下一次任务重新打印首个点位和状态
+    point_filter_.reset();
+    status_filter_.reset();
 
     spdlog::info("[{}]: 导航任务执行状态: 已结束", common::getCurrentTimestamp());
-    std::shared_ptr<common::NavigationTaskEvent> event = std::make_shared<common::NavigationTaskEvent>();
-    event->status = "已完成";
+    common::NavigationTaskEvent event;
+    event.status = "已完成";
     common::EventBus::getInstance().publish(event);
 }
 
 // TODO: 当业务复杂度增加时，需要增加concurrency 逻辑， 包括两种 1.消息处理 2.状态机处理
 // TODO: 针对Resp消息，当逻辑复杂度增加时可以改成EvenBus，比如增加messageId check等
 void X30InspectionSystem::messageProcessingLoop() {
+    common::setupThread("x30-msg");
+    std::vector<std::unique_ptr<protocol::IMessage>> batch;
+    batch.reserve(MAX_BATCH_SIZE);
     while (message_queue_running_) {
-        auto message = message_queue_.pop();
-        if (message) {
-            switch (message->getType()) {
-                case protocol::MessageType::NAVIGATION_TASK_REQ: {  // 导航任务请求
-                    startInspection();
-                    break;
-                }
-                case protocol::MessageType::CANCEL_TASK_REQ: {  // 取消任务请求
-                    cancelInspection();
-                    break;
-                }
-                case protocol::MessageType::QUERY_STATUS_REQ: {  // 状态查询请求
-                    queryStatus();
-                    break;
-                }
-                case protocol::MessageType::PROCEDURE_RESET: {  // 导航过程重置
-                    resetNavProcedure();
-                    break;
-                }
-                case protocol::MessageType::GET_REAL_TIME_STATUS_RESP: {  // 实时状态响应
-                    auto resp = dynamic_cast<const protocol::GetRealTimeStatusResponse&>(*message);
-                    printLog(resp);
-                    auto event = common::GetRealTimeStatusEvent::fromResponse(resp);
-                    common::EventBus::getInstance().publish(event);
-                    break;
-                }
-                case protocol::MessageType::NAVIGATION_TASK_RESP: {  // 导航任务响应
-                    if (nav_state_procedure_) {
-                        nav_state_procedure_->process_event(*message);
-                    }
-                    break;
-                }
-                case protocol::MessageType::CANCEL_TASK_RESP: {  // 取消任务响应
-                    if (nav_state_procedure_) {
-                        nav_state_procedure_->process_event(*message);
-                    }
-                    break;
-                }
-                case protocol::MessageType::QUERY_STATUS_RESP: {  // 状态查询响应
-                    auto resp = dynamic_cast<const protocol::QueryStatusResponse&>(*message);
-                    printLog(resp);
-                    auto event = common::QueryStatusEvent::fromResponse(resp);
-
-                    common::EventBus::getInstance().publish(event);
-
-                    if (nav_state_procedure_) {
-                        nav_state_procedure_->process_event(*message);
-                    }
-
-                    break;
-                }
-                default: {
-                    handleError("收到异常消息");
-                    break;
-                }
+        // 每次唤醒处理一批消息, 减少与网络线程之间的锁交接和线程切换
+        batch.clear();
+        if (message_queue_.drain(batch, MAX_BATCH_SIZE) == 0) {
+            continue;
+        }
+
+        // 同一批次中只有最新的实时状态有意义, 之前的直接丢弃
+        const protocol::IMessage* latest_telemetry = nullptr;
+        for (const auto& message : batch) {
+            if (message->getType() == protocol::MessageType::GET_REAL_TIME_STATUS_RESP) {
+                latest_telemetry = message.get();
+            }
+        }
+        for (const auto& message : batch) {
+            if (message->getType() == protocol::MessageType::GET_REAL_TIME_STATUS_RESP &&
+                message.get() != latest_telemetry) {
+                continue;
             }
+            // 导航过程结束时只清掉了队列中的任务响应, 已取到本批次中的同样丢弃, 直到PROCEDURE_RESET重置过程
+            if (nav_state_procedure_ && nav_state_procedure_->finished() &&
+                std::find(state::NAV_TASK_RESPONSES.begin(), state::NAV_TASK_RESPONSES.end(), message->getType()) !=
+                    state::NAV_TASK_RESPONSES.end()) {
+                continue;
+            }
+            // 恢复网络线程采样的追踪id, 本线程上的处理和由此发出的请求都记入同一条追踪
+            const auto& trace_tag = message->traceTag();
+            common::TraceScope trace_scope(trace_tag.id);
+            common::Tracer::getInstance().record("queue_wait", trace_tag.id, trace_tag.queued_ns,
+                                                 common::Tracer::now());
+            X30_TRACE_SPAN("process_message");
+            processMessage(*message);
         }
     }
 }
 
-void X30InspectionSystem::printLog(const protocol::QueryStatusResponse& resp) const {
+void X30InspectionSystem::processMessage(const protocol::IMessage& message) {
+    static auto& duration = common::MetricsRegistry::getInstance().histogram(
+        "x30_message_process_duration_ns", "消息处理线程处理一条消息的耗时, 纳秒");
+    common::ScopedTimer timer(duration);
+    switch (message.getType()) {
+        case protocol::MessageType::NAVIGATION_TASK_REQ: {  // 导航任务请求
+            startInspection();
+            break;
+        }
+        case protocol::MessageType::CANCEL_TASK_REQ: {  // 取消任务请求
+            cancelInspection();
+            break;
+        }
+        case protocol::MessageType::QUERY_STATUS_REQ: {  // 状态查询请求
+            queryStatus();
+            break;
+        }
+        case protocol::MessageType::PROCEDURE_RESET: {  // 导航过程重置
+            resetNavProcedure();
+            break;
+        }
+        case protocol::MessageType::GET_REAL_TIME_STATUS_RESP: {  // 实时状态响应
+            const auto& resp = static_cast<const protocol::GetRealTimeStatusResponse&>(message);
+            printLog(resp);
+            real_time_status_event_.assign(resp);
+            common::EventBus::getInstance().publish(real_time_status_event_);
+            break;
+        }
+        case protocol::MessageType::NAVIGATION_TASK_RESP: {  // 导航任务响应
+            if (nav_state_procedure_) {
+                nav_state_procedure_->process_event(message);
+            }
+            break;
+        }
+        case protocol::MessageType::CANCEL_TASK_RESP: {  // 取消任务响应
+            if (nav_state_procedure_) {
+                nav_state_procedure_->process_event(message);
+            }
+            break;
+        }
+        case protocol::MessageType::QUERY_STATUS_RESP: {  // 状态查询响应
+            const auto& resp = static_cast<const protocol::QueryStatusResponse&>(message);
+            query_status_event_.assign(resp);
+            common::EventBus::getInstance().publish(query_status_event_);
+
+            // 无导航任务时收到的2007为空闲心跳探测的响应, 不打印
+            if (nav_state_procedure_) {
+                printLog(resp);
+                nav_state_procedure_->process_event(message);
+            }
+
+            break;
+        }
+        default: {
+            handleError("收到异常消息");
+            break;
+        }
+    }
+}
 
+void X30InspectionSystem::printLog(const protocol::QueryStatusResponse& resp) {
+    // 每个样本都记入二进制日志, 文本日志只输出变化和限流后的部分
+    X30_BLOG(spdlog::level::info, "2007状态查询: status: {}, value: {}, errorCode: {}", resp.status, resp.value,
+             resp.errorCode);
+    bool status_changed = status_filter_.changed(resp.status);
     if (resp.status == protocol::NavigationStatus::EXECUTING) {
-        static int lastValue = 0;
-        if (lastValue != resp.value) {
-            lastValue = resp.value;
+        // 只在目标点位变化时打印
+        if (point_filter_.changed(resp.value)) {
             auto&& point = point_map_[resp.value];
             spdlog::info(
-                "[{}]: 正在前往点位 {}， 目标点类型: {}，点位坐标: [{.5f}, {.5f}, {.5f}]  "
+                "[{}]: 正在前往点位 {}， 目标点类型: {}，点位坐标: [{:.5f}, {:.5f}, {:.5f}]  "
                 "********************************",
                 common::getCurrentTimestamp(), resp.value, common::convertPointType(point.pointInfo), point.posX,
                 point.posY, point.posZ);
         }
     }
     else if (resp.status == protocol::NavigationStatus::FAILED) {
-        spdlog::error("[{}]: 查询到设备运行状态异常, status: {}", common::getCurrentTimestamp(),
-                      static_cast<int>(resp.status));
+        // 状态变化时立即打印, 持续异常期间限流
+        if (status_changed || status_log_limiter_.allow(spdlog::level::err)) {
+            spdlog::error("[{}]: 查询到设备运行状态异常, status: {}", common::getCurrentTimestamp(),
+                          static_cast<int>(resp.status));
+        }
     }
     else if (resp.status == protocol::NavigationStatus::COMPLETED) {
-        spdlog::info("[{}]: 查询到导航任务执行完成, status: {}", common::getCurrentTimestamp(),
-                     static_cast<int>(resp.status));
+        if (status_changed || status_log_limiter_.allow(spdlog::level::info)) {
+            spdlog::info("[{}]: 查询到导航任务执行完成, status: {}", common::getCurrentTimestamp(),
+                         static_cast<int>(resp.status));
+        }
     }
 }
 
-void X30InspectionSystem::printLog(const protocol::GetRealTimeStatusResponse& resp) const {
-    spdlog::info("[{}]: 当前位置坐标: [{.5f}, {.5f}, {.5f}]，累计里程数：{:.2f}, 机器人定位状态: {}",
-                 common::getCurrentTimestamp(), resp.posX, resp.posY, resp.posZ, resp.sumOdom, resp.location);
+void X30InspectionSystem::printLog(const protocol::GetRealTimeStatusResponse& resp) {
+    X30_BLOG(spdlog::level::info, "当前位置坐标: [{:.5f}, {:.5f}, {:.5f}]，累计里程数：{:.2f}, 机器人定位状态: {}",
+             resp.posX, resp.posY, resp.posZ, resp.sumOdom, resp.location);
+    // 定位状态变化时不受限流影响, 立即打印
+    if (location_filter_.changed(resp.location)) {
+        spdlog::log(resp.location == 0 ? spdlog::level::info : spdlog::level::warn,
+                    "[{}]: 机器人定位状态变化: {}", common::getCurrentTimestamp(),
+                    resp.location == 0 ? "定位正常" : "定位丢失");
+    }
+    if (real_time_log_limiter_.allow(spdlog::level::info)) {
+        spdlog::info("[{}]: 当前位置坐标: [{:.5f}, {:.5f}, {:.5f}]，累计里程数：{:.2f}, 机器人定位状态: {}",
+                     common::getCurrentTimestamp(), resp.posX, resp.posY, resp.posZ, resp.sumOdom, resp.location);
+    }
 }
 
 void X30InspectionSystem::handleError(const std::string& error) const {
-    std::shared_ptr<common::ErrorEvent> event = std::make_shared<common::ErrorEvent>();
-    event->code = -1;
-    event->message = error;
-    spdlog::error("[{}]: 错误 [{}]: {}", common::getCurrentTimestamp(), event->code, event->message);
+    common::ErrorEvent event;
+    event.code = -1;
+    event.message = error;
+    spdlog::error("[{}]: 错误 [{}]: {}", common::getCurrentTimestamp(), event.code, event.message);
     common::EventBus::getInstance().publish(event);
 }
 
@@ -0,0 +1,209 @@
+#include "common/async_log_sink.hpp"
+#include <spdlog/fmt/fmt.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "common/thread_config.hpp"
+#include "common/utils.hpp"
+
+namespace common {
+
+namespace {
+
+// 写线程空闲时的轮询间隔; 普通日志不逐条唤醒写线程, 避免每次调用都产生一次futex唤醒和线程切换
+constexpr auto WRITER_POLL_INTERVAL = std::chrono::milliseconds(10);
+// DROP_NEWEST下预留给error及以上级别的槽位比例(1/n), 普通日志占满队列时错误日志仍能入队
+constexpr size_t ERROR_RESERVE_DIVISOR = 16;
+// 被截断的正文以此结尾
+constexpr char TRUNCATED_MARK[] = "…[truncated]";
+constexpr size_t TRUNCATED_MARK_SIZE = sizeof(TRUNCATED_MARK) - 1;
+
+// 截断到不超过limit字节, 且不拆开UTF-8多字节字符
+size_t utf8Truncate(const char* data, size_t size, size_t limit) {
+    if (size <= limit) {
+        return size;
+    }
+    size_t end = limit;
+    while (end > 0 && (static_cast<unsigned char>(data[end]) & 0xC0) == 0x80) {
+        --end;
+    }
+    return end;
+}
+
+}  // namespace
+
+AsyncLogSink::AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t queue_capacity,
+                           AsyncLogOverflowPolicy overflow_policy)
+    : sinks_(std::move(sinks)),
+      overflow_policy_(overflow_policy),
+      queue_(queue_capacity),
+      normal_limit_(queue_.capacity() - std::max<size_t>(queue_.capacity() / ERROR_RESERVE_DIVISOR, 1)) {
+    writer_thread_ = std::thread(&AsyncLogSink::writerLoop, this);
+}
+
+AsyncLogSink::~AsyncLogSink() {
+    running_.store(false, std::memory_order_release);
+    not_empty_.notify();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+    for (auto& sink : sinks_) {
+        sink->flush();
+    }
+}
+
+void AsyncLogSink::log(const spdlog::details::log_msg& msg) {
+    Record record;
+    record.time = msg.time;
+    record.source = msg.source;
+    record.thread_id = msg.thread_id;
+    record.level = msg.level;
+    record.logger_name_size = static_cast<uint8_t>(std::min(msg.logger_name.size(), LOGGER_NAME_CAPACITY));
+    std::memcpy(record.logger_name, msg.logger_name.data(), record.logger_name_size);
+    if (msg.payload.size() <= PAYLOAD_CAPACITY) {
+        record.payload_size = static_cast<uint16_t>(msg.payload.size());
+        std::memcpy(record.payload, msg.payload.data(), record.payload_size);
+    }
+    else {
+        // 截断后加上标记, 避免被截断的日志看起来是完整的
+        size_t size = utf8Truncate(msg.payload.data(), msg.payload.size(), PAYLOAD_CAPACITY - TRUNCATED_MARK_SIZE);
+        std::memcpy(record.payload, msg.payload.data(), size);
+        std::memcpy(record.payload + size, TRUNCATED_MARK, TRUNCATED_MARK_SIZE);
+        record.payload_size = static_cast<uint16_t>(size + TRUNCATED_MARK_SIZE);
+    }
+
+    bool is_error = msg.level >= spdlog::level::err;
+    if (overflow_policy_ == AsyncLogOverflowPolicy::DROP_NEWEST) {
+        // 任何级别都不等待: 错误日志多来自网络和心跳路径, 不能因日志卡住
+        if ((!is_error && queue_.sizeApprox() >= normal_limit_) || !queue_.tryPush(std::move(record))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    else {
+        while (!queue_.tryPush(std::move(record))) {
+            not_empty_.notify();
+            auto key = not_full_.prepareWait();
+            if (queue_.sizeApprox() < queue_.capacity()) {
+                not_full_.cancelWait(key);
+                continue;
+            }
+            not_full_.wait(key);
+        }
+    }
+    // 只有error及以上级别或队列过半时才立即唤醒写线程, 其余由写线程定时轮询取走
+    if (is_error || queue_.sizeApprox() >= queue_.capacity() / 2) {
+        not_empty_.notify();
+    }
+}
+
+void AsyncLogSink::flush() {
+    uint64_t target = queue_.produced();
+    not_empty_.notify();
+    while (written_.load(std::memory_order_acquire) < target) {
+        auto key = written_event_.prepareWait();
+        if (written_.load(std::memory_order_acquire) >= target) {
+            written_event_.cancelWait(key);
+            break;
+        }
+        written_event_.wait(key);
+    }
+    for (auto& sink : sinks_) {
+        sink->flush();
+    }
+}
+
+void AsyncLogSink::set_pattern(const std::string& pattern) {
+    for (auto& sink : sinks_) {
+        sink->set_pattern(pattern);
+    }
+}
+
+void AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) {
+    for (auto& sink : sinks_) {
+        sink->set_formatter(sink_formatter->clone());
+    }
+}
+
+uint64_t AsyncLogSink::dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void AsyncLogSink::writerLoop() {
+    setupThread("x30-log");
+    Record record;
+    while (true) {
+        size_t count = 0;
+        while (queue_.tryPop(record)) {
+            write(record);
+            written_.fetch_add(1, std::memory_order_release);
+            ++count;
+        }
+        if (count > 0) {
+            not_full_.notify();
+            written_event_.notify();
+            reportDropped();
+            continue;
+        }
+
+        // 退出前已取空; 已抢占但尚未发布的槽位会让sizeApprox非零, 继续等待其发布
+        bool running = running_.load(std::memory_order_acquire);
+        if (!running && queue_.sizeApprox() == 0) {
+            break;
+        }
+        auto key = not_empty_.prepareWait();
+        if (queue_.sizeApprox() > 0 || !running_.load(std::memory_order_acquire)) {
+            not_empty_.cancelWait(key);
+            if (queue_.sizeApprox() > 0) {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        not_empty_.waitFor(key, WRITER_POLL_INTERVAL);
+    }
+    reportDropped();
+}
+
+void AsyncLogSink::write(const Record& record) {
+    spdlog::details::log_msg msg(record.time, record.source,
+                                 spdlog::string_view_t(record.logger_name, record.logger_name_size), record.level,
+                                 spdlog::string_view_t(record.payload, record.payload_size));
+    msg.thread_id = record.thread_id;
+    bool flush = record.level >= spdlog::level::err;
+    for (auto& sink : sinks_) {
+        try {
+            if (sink->should_log(msg.level)) {
+                sink->log(msg);
+            }
+            if (flush) {
+                sink->flush();
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "AsyncLogSink写日志失败: " << e.what() << std::endl;
+        }
+    }
+}
+
+void AsyncLogSink::reportDropped() {
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped == reported_dropped_) {
+        return;
+    }
+    std::string text = fmt::format("[{}]: [AsyncLogSink:WRN]: 日志队列已满, 丢弃 {} 条日志",
+                                   common::getCurrentTimestamp(), dropped - reported_dropped_);
+    reported_dropped_ = dropped;
+    spdlog::details::log_msg msg(spdlog::string_view_t(), spdlog::level::warn, text);
+    for (auto& sink : sinks_) {
+        try {
+            if (sink->should_log(msg.level)) {
+                sink->log(msg);
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "AsyncLogSink写日志失败: " << e.what() << std::endl;
+        }
+    }
+}
+
+}  // namespace common
@@ -0,0 +1,308 @@
+#include "common/binary_log.hpp"
+#include <fcntl.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <limits>
+#include "common/thread_config.hpp"
+#include "common/utils.hpp"
+
+namespace common {
+
+namespace {
+// 单文件上限的下限, 避免格式定义就占满一个文件
+constexpr size_t MIN_FILE_SIZE = 1024 * 1024;
+}  // namespace
+
+constexpr char BinaryLogger::MAGIC[8];
+constexpr size_t BinaryLogger::DEFAULT_MAX_FILE_SIZE;
+constexpr size_t BinaryLogger::DEFAULT_MAX_FILES;
+
+BinaryLogger::~BinaryLogger() {
+    close();
+}
+
+bool BinaryLogger::open(const std::string& path, size_t max_file_size, size_t max_files) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ != -1) {
+            return true;
+        }
+        path_ = path;
+        next_path_ = path + ".next";
+        max_file_size_ = std::max(max_file_size, MIN_FILE_SIZE);
+        max_files_ = std::max<size_t>(max_files, 1);
+
+        // 首个文件在调用线程中创建, 此时还没有日志写入
+        rotateFiles();
+        Segment segment;
+        if (!createSegment(path_, segment)) {
+            return false;
+        }
+        startSegment(segment);
+        dropped_ = 0;
+        reported_dropped_ = 0;
+        stopping_ = false;
+        open_.store(true, std::memory_order_release);
+    }
+    segment_thread_ = std::thread(&BinaryLogger::segmentLoop, this);
+
+    spdlog::info("[{}]: [BinaryLogger:INFO]: 二进制日志已开启: {}, 单文件上限 {} 字节, 保留 {} 个历史文件",
+                 common::getCurrentTimestamp(), path, max_file_size_, max_files_);
+    return true;
+}
+
+void BinaryLogger::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ == -1) {
+            return;
+        }
+        open_.store(false, std::memory_order_release);
+        stopping_ = true;
+    }
+    // 后台线程退出前会收尾已写满的文件
+    segment_cv_.notify_all();
+    if (segment_thread_.joinable()) {
+        segment_thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Segment current{fd_, data_, capacity_, offset_};
+    finishSegment(current);
+    fd_ = -1;
+    data_ = nullptr;
+    capacity_ = 0;
+    if (next_) {
+        finishSegment(*next_);
+        ::unlink(next_path_.c_str());
+        next_.reset();
+    }
+    spdlog::info("[{}]: [BinaryLogger:INFO]: 二进制日志已关闭: {}, {} 字节", common::getCurrentTimestamp(), path_,
+                 offset_);
+}
+
+bool BinaryLogger::createSegment(const std::string& path, Segment& segment) const {
+    // O_EXCL: 滚动失败时path_仍然存在, 不覆盖其中的记录
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        spdlog::error("[{}]: [BinaryLogger:ERR]: 打开二进制日志文件失败: {}, {}", common::getCurrentTimestamp(),
+                      path, strerror(errno));
+        return false;
+    }
+    // 一次映射到单文件上限, 写入过程中不再扩展; 未写入的部分不占磁盘空间, 关闭时截掉
+    if (ftruncate(fd, static_cast<off_t>(max_file_size_)) == -1) {
+        spdlog::error("[{}]: [BinaryLogger:ERR]: 扩展二进制日志文件失败: {}", common::getCurrentTimestamp(),
+                      strerror(errno));
+        ::close(fd);
+        ::unlink(path.c_str());
+        return false;
+    }
+    void* mapped = mmap(nullptr, max_file_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        spdlog::error("[{}]: [BinaryLogger:ERR]: 映射二进制日志文件失败: {}", common::getCurrentTimestamp(),
+                      strerror(errno));
+        ::close(fd);
+        ::unlink(path.c_str());
+        return false;
+    }
+    segment.fd = fd;
+    segment.data = static_cast<uint8_t*>(mapped);
+    segment.capacity = max_file_size_;
+    segment.offset = 0;
+    return true;
+}
+
+void BinaryLogger::finishSegment(Segment& segment) const {
+    munmap(segment.data, segment.capacity);
+    // 截掉预留的空白部分
+    if (ftruncate(segment.fd, static_cast<off_t>(segment.offset)) == -1) {
+        spdlog::warn("[{}]: [BinaryLogger:WRN]: 截断二进制日志文件失败: {}", common::getCurrentTimestamp(),
+                     strerror(errno));
+    }
+    ::close(segment.fd);
+    segment = Segment{};
+}
+
+void BinaryLogger::rotateFiles() const {
+    // 与rotating_file_sink相同的命名: x30_telemetry.blog -> x30_telemetry.1.blog -> ...
+    for (size_t i = max_files_; i > 0; --i) {
+        std::string src = spdlog::sinks::rotating_file_sink_mt::calc_filename(path_, i - 1);
+        if (::access(src.c_str(), F_OK) != 0) {
+            continue;
+        }
+        std::string target = spdlog::sinks::rotating_file_sink_mt::calc_filename(path_, i);
+        if (::rename(src.c_str(), target.c_str()) == -1) {
+            spdlog::warn("[{}]: [BinaryLogger:WRN]: 滚动二进制日志文件失败: {} -> {}, {}",
+                         common::getCurrentTimestamp(), src, target, strerror(errno));
+        }
+    }
+}
+
+void BinaryLogger::startSegment(const Segment& segment) {
+    fd_ = segment.fd;
+    data_ = segment.data;
+    capacity_ = segment.capacity;
+
+    BinaryLogFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.start_wall_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    memcpy(data_, &header, sizeof(header));
+    offset_ = sizeof(header);
+    start_ = std::chrono::steady_clock::now();
+
+    // 已注册的调用点补写格式定义, 每个文件都能单独解码
+    for (size_t i = 0; i < formats_.size(); ++i) {
+        writeFormat(static_cast<uint16_t>(i + 1), formats_[i]);
+    }
+}
+
+bool BinaryLogger::switchSegment() {
+    // 上一个文件还在收尾或下一个文件还没映射好; 不在调用线程中做文件I/O, 丢弃本条记录
+    if (!next_) {
+        ++dropped_;
+        return false;
+    }
+    retired_ = Segment{fd_, data_, capacity_, offset_};
+    startSegment(*next_);
+    next_.reset();
+    segment_cv_.notify_one();
+    return true;
+}
+
+void BinaryLogger::segmentLoop() {
+    common::setupThread("x30-blog");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        segment_cv_.wait(lock, [this] { return stopping_ || retired_ || !next_; });
+
+        if (retired_) {
+            Segment retired = *retired_;
+            retired_.reset();
+            uint64_t dropped = dropped_ - reported_dropped_;
+            reported_dropped_ = dropped_;
+            lock.unlock();
+            finishSegment(retired);
+            // 写满的文件仍叫path_, 当前文件还叫next_path_, 依次改名后当前文件成为path_
+            rotateFiles();
+            if (::rename(next_path_.c_str(), path_.c_str()) == -1) {
+                spdlog::warn("[{}]: [BinaryLogger:WRN]: 滚动二进制日志文件失败: {} -> {}, {}",
+                             common::getCurrentTimestamp(), next_path_, path_, strerror(errno));
+            }
+            spdlog::info("[{}]: [BinaryLogger:INFO]: 二进制日志已滚动: {}", common::getCurrentTimestamp(), path_);
+            if (dropped > 0) {
+                spdlog::warn("[{}]: [BinaryLogger:WRN]: 滚动期间下一个文件未就绪, 丢弃 {} 条记录",
+                             common::getCurrentTimestamp(), dropped);
+            }
+            lock.lock();
+            continue;
+        }
+        if (stopping_) {
+            return;
+        }
+
+        // 预先映射下一个文件; 残留的临时文件来自异常退出, 直接删除
+        lock.unlock();
+        ::unlink(next_path_.c_str());
+        Segment segment;
+        bool created = createSegment(next_path_, segment);
+        lock.lock();
+        if (!created) {
+            // 稍后重试, 期间写满的记录被丢弃并计数
+            if (segment_cv_.wait_for(lock, std::chrono::seconds(1), [this] { return stopping_; })) {
+                return;
+            }
+            continue;
+        }
+        next_ = segment;
+    }
+}
+
+uint16_t BinaryLogger::registerSite(BinaryLogSite& site, const char* format, const char* signature) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint16_t id = site.id.load(std::memory_order_relaxed);
+    if (id != 0) {
+        return id;
+    }
+    if (formats_.size() >= std::numeric_limits<uint16_t>::max()) {
+        return 0;
+    }
+    formats_.push_back({site.level, site.file, site.line, format, signature});
+    id = static_cast<uint16_t>(formats_.size());
+    if (fd_ != -1) {
+        writeFormat(id, formats_.back());
+    }
+    site.id.store(id, std::memory_order_release);
+    return id;
+}
+
+uint8_t* BinaryLogger::beginRecord(BinaryLogRecordType type, uint16_t format_id, size_t length,
+                                   std::chrono::steady_clock::time_point now) {
+    if (fd_ == -1 || format_id == 0 || length > std::numeric_limits<uint16_t>::max()) {
+        return nullptr;
+    }
+    // 额外预留一条记录头, 保证文件中总有一个type为END的结束标记
+    size_t required = offset_ + 2 * sizeof(BinaryLogRecordHeader) + length;
+    // 格式定义随文件重写, 不触发滚动
+    if (type == BinaryLogRecordType::ENTRY && required > capacity_) {
+        if (!switchSegment()) {
+            return nullptr;
+        }
+        required = offset_ + 2 * sizeof(BinaryLogRecordHeader) + length;
+    }
+    if (required > capacity_) {
+        return nullptr;
+    }
+
+    BinaryLogRecordHeader header;
+    header.type = static_cast<uint8_t>(type);
+    header.format_id = format_id;
+    header.length = static_cast<uint16_t>(length);
+    // 调用方在加锁前取的时间可能早于滚动后新文件的起点
+    header.timestamp_ns = type == BinaryLogRecordType::FORMAT || now < start_
+                              ? 0
+                              : static_cast<uint64_t>(
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count());
+    uint8_t* dst = data_ + offset_;
+    memcpy(dst, &header, sizeof(header));
+    offset_ += sizeof(header) + length;
+    return dst + sizeof(header);
+}
+
+void BinaryLogger::writeFormat(uint16_t format_id, const Format& format) {
+    auto field = [](uint8_t* dst, const char* text, size_t length_size) {
+        size_t length = strlen(text);
+        if (length_size == 1) {
+            uint8_t size = static_cast<uint8_t>(length);
+            memcpy(dst, &size, sizeof(size));
+        }
+        else {
+            uint16_t size = static_cast<uint16_t>(length);
+            memcpy(dst, &size, sizeof(size));
+        }
+        memcpy(dst + length_size, text, length);
+        return dst + length_size + length;
+    };
+
+    size_t length = 1 + sizeof(int32_t) + 1 + strlen(format.signature) + 2 + strlen(format.file) + 2 +
+                    strlen(format.format);
+    uint8_t* dst = beginRecord(BinaryLogRecordType::FORMAT, format_id, length, start_);
+    if (dst == nullptr) {
+        return;
+    }
+    *dst++ = static_cast<uint8_t>(format.level);
+    int32_t line = format.line;
+    memcpy(dst, &line, sizeof(line));
+    dst += sizeof(line);
+    dst = field(dst, format.signature, 1);
+    dst = field(dst, format.file, 2);
+    field(dst, format.format, 2);
+}
+
+}  // namespace common
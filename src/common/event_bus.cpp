@@ -1,46 +1,187 @@
 #include "common/event_bus.hpp"
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include "common/thread_config.hpp"
 #include "common/utils.hpp"
 // #include <fmt/core.h>
 #include <spdlog/spdlog.h>
 namespace common {
 
-void EventBus::unsubscribe(const std::string& eventType, const std::string& handlerId) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = handlers_.find(eventType);
-    if (it != handlers_.end()) {
-        it->second.erase(handlerId);
+namespace {
+constexpr size_t MAILBOX_BATCH_SIZE = 32;  // 分发线程每次从单个邮箱取出的事件数, 超出后让出给其他邮箱
+}  // namespace
+
+EventBus::~EventBus() {
+    {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        dispatch_stopping_ = true;
+    }
+    dispatch_cv_.notify_all();
+    for (auto& thread : dispatch_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+EventBus::BusMetrics& EventBus::busMetrics() {
+    auto& registry = MetricsRegistry::getInstance();
+    static BusMetrics metrics{
+        registry.counter("x30_events_published_total", "EventBus发布的事件数"),
+        registry.histogram("x30_event_publish_duration_ns", "EventBus publish耗时, 纳秒"),
+        registry.counter("x30_events_async_dropped_total", "异步订阅者邮箱溢出丢弃的事件数"),
+        registry.histogram("x30_event_dispatch_duration_ns", "异步处理器单次执行耗时, 纳秒"),
+    };
+    return metrics;
+}
+
+size_t EventBus::nextTypeId() {
+    static std::atomic<size_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EventBus::unsubscribe(HandlerId handler_id) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto slots = std::make_shared<Slots>(*std::atomic_load(&slots_));
+    for (auto& subscriptions : *slots) {
+        auto it = std::find_if(subscriptions.begin(), subscriptions.end(),
+                               [handler_id](const Subscription& subscription) { return subscription.id == handler_id; });
+        if (it != subscriptions.end()) {
+            if (it->mailbox) {
+                std::lock_guard<std::mutex> mailbox_lock(it->mailbox->mutex);
+                it->mailbox->closed = true;
+                it->mailbox->clear();
+                it->mailbox->not_full_cv.notify_all();
+            }
+            subscriptions.erase(it);
+            std::atomic_store(&slots_, std::shared_ptr<const Slots>(std::move(slots)));
+            return;
+        }
+    }
+}
+
+uint64_t EventBus::droppedEvents(HandlerId handler_id) const {
+    auto slots = std::atomic_load(&slots_);
+    for (const auto& subscriptions : *slots) {
+        for (const auto& subscription : subscriptions) {
+            if (subscription.id == handler_id) {
+                return subscription.mailbox ? subscription.mailbox->dropped.load(std::memory_order_relaxed) : 0;
+            }
+        }
     }
+    return 0;
 }
 
-void EventBus::publish(const std::shared_ptr<Event>& event) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = handlers_.find(event->getType());
-    if (it != handlers_.end()) {
-        for (const auto& [_, handler] : it->second) {
-            handler(event);
+void EventBus::post(const std::shared_ptr<Mailbox>& mailbox, std::shared_ptr<const Event> event) {
+    std::unique_lock<std::mutex> lock(mailbox->mutex);
+    while (!mailbox->closed && mailbox->full()) {
+        switch (mailbox->overflow_policy) {
+            case MailboxOverflowPolicy::DROP_OLDEST:
+                mailbox->popFront();
+                mailbox->dropped.fetch_add(1, std::memory_order_relaxed);
+                busMetrics().async_dropped.inc();
+                break;
+            case MailboxOverflowPolicy::DROP_NEWEST:
+                mailbox->dropped.fetch_add(1, std::memory_order_relaxed);
+                busMetrics().async_dropped.inc();
+                return;
+            case MailboxOverflowPolicy::BLOCK:
+                mailbox->not_full_cv.wait(lock);
+                break;
         }
     }
-    else {
-        spdlog::warn("[{}]: [EventBus:WRN]: 找不到事件处理函数: {}", common::getCurrentTimestamp(), event->getType());
-        // std::cout << fmt::format("[{}]: 找不到事件处理函数: {}", common::getCurrentTimestamp(), event->getType()) << std::endl;
+    if (mailbox->closed) {
+        return;
+    }
+    mailbox->pushBack(std::move(event));
+    if (mailbox->scheduled) {
+        return;  // 已有分发线程负责该邮箱, 它会在处理完当前批次后继续取出新事件
     }
+    mailbox->scheduled = true;
+    lock.unlock();
+    schedule(mailbox);
 }
 
-void EventBus::publish(const std::shared_ptr<Event>& event, const std::string& handlerId) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = handlers_.find(event->getType());
-    if (it != handlers_.end()) {
-        auto handler = it->second.find(handlerId);
-        if (handler != it->second.end()) {
-            handler->second(event);
+void EventBus::schedule(std::shared_ptr<Mailbox> mailbox) {
+    {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        Mailbox* tail = mailbox.get();
+        if (ready_tail_) {
+            ready_tail_->next_ready = std::move(mailbox);
         }
         else {
-            spdlog::warn("[{}]: [EventBus:WRN]: 找不到事件处理函数: {}, handlerId={}", common::getCurrentTimestamp(),
-                         event->getType(), handlerId);
-            // std::cout << fmt::format("[{}]: 找不到事件处理函数: {}, handlerId={}", common::getCurrentTimestamp(), event->getType(), handlerId) << std::endl;
+            ready_head_ = std::move(mailbox);
         }
+        ready_tail_ = tail;
     }
+    dispatch_cv_.notify_one();
+}
+
+void EventBus::startDispatcher() {
+    std::lock_guard<std::mutex> lock(dispatch_mutex_);
+    if (!dispatch_threads_.empty() || dispatch_stopping_) {
+        return;
+    }
+    for (size_t i = 0; i < DISPATCH_THREADS; ++i) {
+        dispatch_threads_.emplace_back([this, i] {
+            setupThread("x30-bus-" + std::to_string(i));
+            dispatchLoop();
+        });
+    }
+    spdlog::info("[{}]: [EventBus:INFO]: 异步分发线程已启动, 线程数: {}", common::getCurrentTimestamp(),
+                 DISPATCH_THREADS);
+}
+
+void EventBus::dispatchLoop() {
+    std::vector<std::shared_ptr<const Event>> batch;
+    batch.reserve(MAILBOX_BATCH_SIZE);
+    while (true) {
+        std::shared_ptr<Mailbox> mailbox;
+        {
+            std::unique_lock<std::mutex> lock(dispatch_mutex_);
+            dispatch_cv_.wait(lock, [this] { return dispatch_stopping_ || ready_head_; });
+            if (dispatch_stopping_) {
+                return;
+            }
+            mailbox = std::move(ready_head_);
+            ready_head_ = std::move(mailbox->next_ready);
+            if (!ready_head_) {
+                ready_tail_ = nullptr;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mailbox->mutex);
+            while (mailbox->count > 0 && batch.size() < MAILBOX_BATCH_SIZE) {
+                batch.push_back(mailbox->popFront());
+            }
+        }
+        mailbox->not_full_cv.notify_all();
+
+        for (const auto& event : batch) {
+            try {
+                ScopedTimer timer(busMetrics().dispatch_duration);
+                mailbox->invoke(*event);
+            } catch (const std::exception& e) {
+                spdlog::error("[{}]: [EventBus:ERR]: 异步事件处理异常: {}, 事件: {}", common::getCurrentTimestamp(),
+                              e.what(), event->getType());
+            }
+        }
+        batch.clear();
+
+        // 邮箱仍有事件则重新排到就绪队列末尾, 避免单个繁忙订阅者独占分发线程
+        std::unique_lock<std::mutex> lock(mailbox->mutex);
+        if (mailbox->closed || mailbox->count == 0) {
+            mailbox->scheduled = false;
+            continue;
+        }
+        lock.unlock();
+        schedule(std::move(mailbox));
+    }
+}
+
+void EventBus::warnNoHandler(const Event& event) {
+    spdlog::warn("[{}]: [EventBus:WRN]: 找不到事件处理函数: {}", common::getCurrentTimestamp(), event.getType());
 }
 
 }  // namespace common
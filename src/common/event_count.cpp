@@ -0,0 +1,80 @@
+#include "common/event_count.hpp"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+
+namespace common {
+
+namespace {
+constexpr uint64_t WAITER_MASK = 0xffffffffULL;
+constexpr int EPOCH_SHIFT = 32;
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "纪元位于state_的高32位, 仅支持小端");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "futex要求atomic与整数布局一致");
+
+uint32_t epochOf(uint64_t state) {
+    return static_cast<uint32_t>(state >> EPOCH_SHIFT);
+}
+
+uint32_t* epochAddress(std::atomic<uint64_t>& state) {
+    return reinterpret_cast<uint32_t*>(&state) + 1;
+}
+}  // namespace
+
+uint64_t EventCount::prepareWait() {
+    return state_.fetch_add(1, std::memory_order_seq_cst);
+}
+
+void EventCount::cancelWait(uint64_t key) {
+    // 纪元未变说明尚未被notify计入, 撤销登记; 否则登记已被notify清除
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    while (epochOf(state) == epochOf(key)) {
+        if (state_.compare_exchange_weak(state, state - 1, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+void EventCount::wait(uint64_t key) {
+    // 纪元已变化时futex立即返回, 不会错过prepareWait之后的通知
+    uint32_t epoch = epochOf(key);
+    while (epochOf(state_.load(std::memory_order_acquire)) == epoch) {
+        syscall(SYS_futex, epochAddress(state_), FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+    }
+}
+
+bool EventCount::waitFor(uint64_t key, std::chrono::nanoseconds timeout) {
+    uint32_t epoch = epochOf(key);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (epochOf(state_.load(std::memory_order_acquire)) == epoch) {
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::nanoseconds::zero()) {
+            cancelWait(key);
+            return epochOf(state_.load(std::memory_order_acquire)) != epoch;
+        }
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        timespec relative{};
+        relative.tv_sec = seconds.count();
+        relative.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count();
+        syscall(SYS_futex, epochAddress(state_), FUTEX_WAIT_PRIVATE, epoch, &relative, nullptr, 0);
+    }
+    return true;
+}
+
+void EventCount::notify() {
+    // 与prepareWait配对: 保证条件的写入对随后检查条件的等待方可见
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    do {
+        if ((state & WAITER_MASK) == 0) {
+            return;
+        }
+        // 推进纪元并清空等待方计数, 之后的notify在等待方重新登记前不再进入内核
+    } while (!state_.compare_exchange_weak(state, (static_cast<uint64_t>(epochOf(state) + 1) << EPOCH_SHIFT),
+                                           std::memory_order_release, std::memory_order_relaxed));
+    syscall(SYS_futex, epochAddress(state_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+}  // namespace common
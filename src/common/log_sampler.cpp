@@ -0,0 +1,42 @@
+#include "common/log_sampler.hpp"
+#include <algorithm>
+#include "common/utils.hpp"
+
+namespace common {
+
+LogRateLimiter::LogRateLimiter(std::string name, double rate_per_second, double burst)
+    : name_(std::move(name)),
+      rate_per_second_(rate_per_second),
+      burst_(std::max(burst, 1.0)),
+      tokens_(burst_),
+      last_refill_(std::chrono::steady_clock::now()) {}
+
+bool LogRateLimiter::allow(spdlog::level::level_enum level) {
+    uint64_t suppressed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+        tokens_ = std::min(burst_, tokens_ + elapsed * rate_per_second_);
+        last_refill_ = now;
+        if (tokens_ < 1.0) {
+            ++suppressed_;
+            ++suppressed_total_;
+            return false;
+        }
+        tokens_ -= 1.0;
+        std::swap(suppressed, suppressed_);
+    }
+    if (suppressed > 0) {
+        spdlog::log(level, "[{}]: [LogSampler:INFO]: {} 限流期间抑制了 {} 条日志", common::getCurrentTimestamp(), name_,
+                    suppressed);
+    }
+    return true;
+}
+
+uint64_t LogRateLimiter::suppressedTotal() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return suppressed_total_;
+}
+
+}  // namespace common
@@ -1,36 +1,636 @@
 #include "common/message_queue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include "common/event_count.hpp"
+#include "common/metrics.hpp"
+#include "common/mpsc_ring.hpp"
+#include "common/probes.hpp"
 
 namespace common {
 
-// TODO: 可以考虑多模型消息队列, 比如无锁队列
-void MessageQueue::push(std::unique_ptr<protocol::IMessage> msg) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.push(std::move(msg));
-    cv_.notify_one();
+using MessagePtr = std::unique_ptr<protocol::IMessage>;
+using TypeList = std::initializer_list<protocol::MessageType>;
+
+class MessageQueue::Impl {
+public:
+    explicit Impl(const MessageQueueOptions& options) : options_(options) {
+    }
+    virtual ~Impl() = default;
+    virtual bool push(MessagePtr msg) = 0;
+    virtual MessagePtr pop() = 0;
+    virtual size_t drain(std::vector<MessagePtr>& out, size_t max) = 0;
+    virtual void clear() = 0;
+    virtual size_t purge(TypeList types) = 0;
+    virtual void close() = 0;
+
+    MessageQueueStats stats() const {
+        MessageQueueStats stats;
+        stats.messages = messages_.load(std::memory_order_relaxed);
+        stats.bytes = bytes_.load(std::memory_order_relaxed);
+        stats.high_water_messages = high_water_messages_.load(std::memory_order_relaxed);
+        stats.high_water_bytes = high_water_bytes_.load(std::memory_order_relaxed);
+        stats.superseded = superseded_.load(std::memory_order_relaxed);
+        stats.dropped_telemetry = dropped_telemetry_.load(std::memory_order_relaxed);
+        stats.rejected = rejected_.load(std::memory_order_relaxed);
+        stats.blocked = blocked_.load(std::memory_order_relaxed);
+        stats.purged = purged_.load(std::memory_order_relaxed);
+        stats.enqueued = enqueued_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+protected:
+    // 加入一条消息后是否超出预算
+    bool exceedsBudget(size_t messages, size_t bytes) const {
+        return (options_.max_messages != 0 && messages > options_.max_messages) ||
+               (options_.max_bytes != 0 && bytes > options_.max_bytes);
+    }
+
+    void added(size_t bytes) {
+        enqueued_.fetch_add(1, std::memory_order_relaxed);
+        charge(bytes);
+    }
+
+    // 计入一条消息的预算, 不检查上限
+    void charge(size_t bytes) {
+        updateHighWater(high_water_messages_, messages_.fetch_add(1, std::memory_order_relaxed) + 1);
+        updateHighWater(high_water_bytes_, bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    }
+
+    // 在预算内原子地预占一条消息, 超出预算时不修改计数并返回false
+    // 条数和字节数分别CAS, 字节数失败时退还已占的条数; 并发生产者不会越过上限
+    bool tryCharge(size_t bytes) {
+        size_t messages = messages_.load(std::memory_order_relaxed);
+        do {
+            if (options_.max_messages != 0 && messages + 1 > options_.max_messages) {
+                return false;
+            }
+        } while (!messages_.compare_exchange_weak(messages, messages + 1, std::memory_order_relaxed));
+
+        size_t current = bytes_.load(std::memory_order_relaxed);
+        do {
+            if (options_.max_bytes != 0 && current + bytes > options_.max_bytes) {
+                messages_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!bytes_.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+
+        updateHighWater(high_water_messages_, messages + 1);
+        updateHighWater(high_water_bytes_, current + bytes);
+        return true;
+    }
+
+    void removed(size_t bytes) {
+        messages_.fetch_sub(1, std::memory_order_relaxed);
+        bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    // 合并时新消息替换旧消息, 条数不变
+    void replaced(size_t old_bytes, size_t new_bytes) {
+        updateHighWater(high_water_bytes_, bytes_.fetch_add(new_bytes, std::memory_order_relaxed) + new_bytes);
+        bytes_.fetch_sub(old_bytes, std::memory_order_relaxed);
+        superseded_.fetch_add(1, std::memory_order_relaxed);
+        enqueued_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void updateHighWater(std::atomic<size_t>& high_water, size_t value) {
+        size_t current = high_water.load(std::memory_order_relaxed);
+        while (value > current && !high_water.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    const MessageQueueOptions options_;
+    std::atomic<size_t> messages_{0};
+    std::atomic<size_t> bytes_{0};
+    std::atomic<size_t> high_water_messages_{0};
+    std::atomic<size_t> high_water_bytes_{0};
+    std::atomic<uint64_t> superseded_{0};
+    std::atomic<uint64_t> dropped_telemetry_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> blocked_{0};
+    std::atomic<uint64_t> purged_{0};
+    std::atomic<uint64_t> enqueued_{0};
+};
+
+namespace {
+
+constexpr size_t CONTROL_LANE = static_cast<size_t>(MessagePriority::CONTROL);
+constexpr size_t TELEMETRY_LANE = static_cast<size_t>(MessagePriority::TELEMETRY);
+
+size_t laneOf(const MessagePtr& msg) {
+    return static_cast<size_t>(MessageQueue::classify(msg->getType()));
 }
 
-std::unique_ptr<protocol::IMessage> MessageQueue::pop() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] { return !queue_.empty() || close_flag_; });
-    if (close_flag_ && queue_.empty()) {
+// 参与合并的消息类型, 返回合并槽位下标, 不参与合并时返回-1
+constexpr size_t CONFLATED_TYPE_COUNT = 1;
+int conflationSlot(protocol::MessageType type) {
+    switch (type) {
+        case protocol::MessageType::GET_REAL_TIME_STATUS_RESP:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+bool matches(const MessagePtr& msg, TypeList types) {
+    return std::find(types.begin(), types.end(), msg->getType()) != types.end();
+}
+
+// 互斥锁+条件变量实现
+class LockedQueue : public MessageQueue::Impl {
+public:
+    using Impl::Impl;
+
+    bool push(MessagePtr msg) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        size_t lane_index = laneOf(msg);
+        auto& lane = lanes_[lane_index];
+        size_t bytes = msg->memoryUsage();
+        if (options_.conflate_telemetry && conflationSlot(msg->getType()) >= 0) {
+            // 同类型的旧消息尚未取走时就地替换, 保持其在通道中的位置
+            auto type = msg->getType();
+            auto it = std::find_if(lane.begin(), lane.end(), [type](const MessagePtr& queued) {
+                return queued->getType() == type;
+            });
+            if (it != lane.end()) {
+                replaced((*it)->memoryUsage(), bytes);
+                *it = std::move(msg);
+                return true;
+            }
+        }
+        if (lane_index != CONTROL_LANE && !makeRoom(lock, lane_index, bytes)) {
+            return false;
+        }
+        added(bytes);
+        lane.push_back(std::move(msg));
+        cv_.notify_one();
+        return true;
+    }
+
+    MessagePtr pop() override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !empty() || close_flag_; });
+        for (auto& lane : lanes_) {
+            if (!lane.empty()) {
+                return take(lane);
+            }
+        }
         return nullptr;
     }
-    auto msg = std::move(queue_.front());
-    queue_.pop();
+
+    size_t drain(std::vector<MessagePtr>& out, size_t max) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !empty() || close_flag_; });
+        size_t count = 0;
+        for (auto& lane : lanes_) {
+            while (count < max && !lane.empty()) {
+                out.push_back(take(lane));
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    void clear() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& lane : lanes_) {
+            while (!lane.empty()) {
+                take(lane);
+                purged_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t purge(TypeList types) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t purged = 0;
+        for (auto& lane : lanes_) {
+            auto it = std::stable_partition(lane.begin(), lane.end(),
+                                            [types](const MessagePtr& msg) { return !matches(msg, types); });
+            for (auto purged_it = it; purged_it != lane.end(); ++purged_it) {
+                removed((*purged_it)->memoryUsage());
+                ++purged;
+            }
+            lane.erase(it, lane.end());
+        }
+        purged_.fetch_add(purged, std::memory_order_relaxed);
+        not_full_cv_.notify_all();
+        return purged;
+    }
+
+    void close() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+        not_full_cv_.notify_all();
+        close_flag_ = true;
+    }
+
+private:
+    bool empty() const {
+        return std::all_of(lanes_.begin(), lanes_.end(), [](const auto& lane) { return lane.empty(); });
+    }
+
+    // 取出通道队首消息并释放其预算, 调用方需持有mutex_
+    MessagePtr take(std::deque<MessagePtr>& lane) {
+        auto msg = std::move(lane.front());
+        lane.pop_front();
+        removed(msg->memoryUsage());
+        not_full_cv_.notify_all();
+        return msg;
+    }
+
+    // 按策略为新消息腾出预算, 返回false表示新消息应被丢弃, 调用方需持有mutex_
+    bool makeRoom(std::unique_lock<std::mutex>& lock, size_t lane_index, size_t bytes) {
+        while (exceedsBudget(messages_ + 1, bytes_ + bytes)) {
+            switch (options_.overflow_policy) {
+                case OverflowPolicy::DROP_OLDEST_TELEMETRY: {
+                    auto& telemetry = lanes_[TELEMETRY_LANE];
+                    if (!telemetry.empty()) {
+                        take(telemetry);
+                        dropped_telemetry_.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    if (lane_index == TELEMETRY_LANE) {
+                        dropped_telemetry_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else {
+                        rejected_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return false;
+                }
+                case OverflowPolicy::REJECT_NEW:
+                    rejected_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                case OverflowPolicy::BLOCK_PRODUCER:
+                    if (close_flag_) {
+                        rejected_.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    blocked_.fetch_add(1, std::memory_order_relaxed);
+                    not_full_cv_.wait(lock);
+                    break;
+            }
+        }
+        return true;
+    }
+
+    std::array<std::deque<MessagePtr>, MessageQueue::LANE_COUNT> lanes_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable not_full_cv_;
+    std::atomic<bool> close_flag_{false};
+};
+
+// 无锁环形队列实现, 每个优先级一个环
+class LockFreeQueue : public MessageQueue::Impl {
+public:
+    explicit LockFreeQueue(const MessageQueueOptions& options)
+        : Impl(options),
+          rings_{std::make_unique<MpscRing<MessagePtr>>(options.capacity),
+                 std::make_unique<MpscRing<MessagePtr>>(options.capacity),
+                 std::make_unique<MpscRing<MessagePtr>>(options.capacity)} {
+    }
+
+    ~LockFreeQueue() override {
+        for (auto& slot : conflated_) {
+            delete slot.exchange(nullptr);
+        }
+    }
+
+    bool push(MessagePtr msg) override {
+        size_t lane_index = laneOf(msg);
+        size_t bytes = msg->memoryUsage();
+        int slot = options_.conflate_telemetry ? conflationSlot(msg->getType()) : -1;
+        if (slot >= 0) {
+            // 合并槽位只保存最新的一条, 被替换的旧消息直接释放
+            MessagePtr previous{conflated_[slot].exchange(msg.release(), std::memory_order_acq_rel)};
+            if (previous) {
+                replaced(previous->memoryUsage(), bytes);
+            }
+            else {
+                added(bytes);
+            }
+            not_empty_.notify();
+            return true;
+        }
+
+        bool control = lane_index == CONTROL_LANE;
+        if (control) {
+            charge(bytes);
+        }
+        else if (!reserve(lane_index, bytes)) {
+            return false;
+        }
+
+        auto& ring = *rings_[lane_index];
+        while (!ring.tryPush(std::move(msg))) {
+            // 通道已满: 控制消息不受预算约束也不丢弃, 总是等待; 其他通道与超出预算时的策略一致
+            if (!control && !overflow(lane_index)) {
+                removed(bytes);
+                return false;
+            }
+            uint64_t key = not_full_.prepareWait();
+            if (close_flag_.load()) {
+                not_full_.cancelWait(key);
+                removed(bytes);
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (ring.tryPush(std::move(msg))) {
+                not_full_.cancelWait(key);
+                break;
+            }
+            blocked_.fetch_add(1, std::memory_order_relaxed);
+            not_full_.wait(key);
+        }
+        enqueued_.fetch_add(1, std::memory_order_relaxed);
+        not_empty_.notify();
+        return true;
+    }
+
+    MessagePtr pop() override {
+        MessagePtr msg;
+        while (!tryPop(msg)) {
+            uint64_t key = not_empty_.prepareWait();
+            if (tryPop(msg)) {
+                not_empty_.cancelWait(key);
+                break;
+            }
+            if (close_flag_.load()) {
+                not_empty_.cancelWait(key);
+                return nullptr;
+            }
+            not_empty_.wait(key);
+        }
+        return msg;
+    }
+
+    size_t drain(std::vector<MessagePtr>& out, size_t max) override {
+        if (max == 0) {
+            return 0;
+        }
+        auto msg = pop();
+        if (!msg) {
+            return 0;
+        }
+        out.push_back(std::move(msg));
+        size_t count = 1;
+        while (count < max && tryPop(msg)) {
+            out.push_back(std::move(msg));
+            ++count;
+        }
+        return count;
+    }
+
+    void clear() override {
+        MessagePtr msg;
+        while (tryPop(msg)) {
+            purged_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    size_t purge(TypeList types) override {
+        // 环中元素无法原地删除: 全部移入消费者私有的暂存区后再过滤, pop先取暂存区以保持顺序
+        MessagePtr msg;
+        size_t purged = 0;
+        for (size_t i = 0; i < MessageQueue::LANE_COUNT; ++i) {
+            while (rings_[i]->tryPop(msg)) {
+                stash_[i].push_back(std::move(msg));
+            }
+            auto& stash = stash_[i];
+            auto it = std::stable_partition(stash.begin(), stash.end(),
+                                            [types](const MessagePtr& queued) { return !matches(queued, types); });
+            for (auto purged_it = it; purged_it != stash.end(); ++purged_it) {
+                removed((*purged_it)->memoryUsage());
+                ++purged;
+            }
+            stash.erase(it, stash.end());
+        }
+        for (auto& slot : conflated_) {
+            MessagePtr conflated{slot.exchange(nullptr, std::memory_order_acq_rel)};
+            if (!conflated) {
+                continue;
+            }
+            if (matches(conflated, types)) {
+                removed(conflated->memoryUsage());
+                ++purged;
+                continue;
+            }
+            // 放回时若生产者已写入更新的消息, 保留更新的那条
+            protocol::IMessage* expected = nullptr;
+            if (slot.compare_exchange_strong(expected, conflated.get(), std::memory_order_acq_rel)) {
+                conflated.release();
+            }
+            else {
+                removed(conflated->memoryUsage());
+                superseded_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        purged_.fetch_add(purged, std::memory_order_relaxed);
+        not_full_.notify();
+        return purged;
+    }
+
+    void close() override {
+        close_flag_ = true;
+        not_empty_.notify();
+        not_full_.notify();
+    }
+
+private:
+    // 通道已满或超出预算时按策略计数, 返回true表示应阻塞等待(仅BLOCK_PRODUCER)
+    bool overflow(size_t lane_index) {
+        switch (options_.overflow_policy) {
+            case OverflowPolicy::DROP_OLDEST_TELEMETRY:
+                if (lane_index == TELEMETRY_LANE) {
+                    dropped_telemetry_.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    rejected_.fetch_add(1, std::memory_order_relaxed);
+                }
+                return false;
+            case OverflowPolicy::REJECT_NEW:
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case OverflowPolicy::BLOCK_PRODUCER:
+                return true;
+        }
+        return false;
+    }
+
+    // 预占预算, 成功返回true且已计入messages_/bytes_; 失败时按策略计数或阻塞等待, 不占用预算
+    bool reserve(size_t lane_index, size_t bytes) {
+        while (!tryCharge(bytes)) {
+            if (!overflow(lane_index)) {
+                return false;
+            }
+            uint64_t key = not_full_.prepareWait();
+            if (close_flag_.load()) {
+                not_full_.cancelWait(key);
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (tryCharge(bytes)) {
+                not_full_.cancelWait(key);
+                return true;
+            }
+            blocked_.fetch_add(1, std::memory_order_relaxed);
+            not_full_.wait(key);
+        }
+        return true;
+    }
+
+    bool tryPop(MessagePtr& msg) {
+        for (size_t i = 0; i < MessageQueue::LANE_COUNT; ++i) {
+            if (!stash_[i].empty()) {
+                msg = std::move(stash_[i].front());
+                stash_[i].pop_front();
+                released(*msg);
+                return true;
+            }
+            auto& ring = *rings_[i];
+            if (ring.tryPop(msg)) {
+                released(*msg);
+                // 腾出一半空间后再唤醒阻塞的生产者, 避免满队列时每次pop都唤醒
+                if (ring.sizeApprox() <= ring.capacity() / 2) {
+                    not_full_.notify();
+                }
+                return true;
+            }
+            if (i == TELEMETRY_LANE) {
+                for (auto& slot : conflated_) {
+                    if (slot.load(std::memory_order_relaxed) != nullptr) {
+                        msg.reset(slot.exchange(nullptr, std::memory_order_acq_rel));
+                        if (msg) {
+                            released(*msg);
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // 消息出队后释放预算, 阻塞在预算上的生产者需要及时唤醒
+    void released(const protocol::IMessage& msg) {
+        removed(msg.memoryUsage());
+        if (options_.overflow_policy == OverflowPolicy::BLOCK_PRODUCER &&
+            (options_.max_messages != 0 || options_.max_bytes != 0)) {
+            not_full_.notify();
+        }
+    }
+
+    std::array<std::unique_ptr<MpscRing<MessagePtr>>, MessageQueue::LANE_COUNT> rings_;
+    std::array<std::deque<MessagePtr>, MessageQueue::LANE_COUNT> stash_;  // 仅消费线程访问
+    std::array<std::atomic<protocol::IMessage*>, CONFLATED_TYPE_COUNT> conflated_{};  // 遥测合并槽位
+    EventCount not_empty_;
+    EventCount not_full_;
+    std::atomic<bool> close_flag_{false};
+};
+
+}  // namespace
+
+MessageQueue::MessageQueue(MessageQueueOptions options) {
+    if (options.type == MessageQueueType::LOCK_FREE) {
+        impl_ = std::make_unique<LockFreeQueue>(options);
+    }
+    else {
+        impl_ = std::make_unique<LockedQueue>(options);
+    }
+
+    // 统计已由队列自身维护, 采集时读取即可, 不在push/pop路径上额外记录
+    collector_id_ = MetricsRegistry::getInstance().addCollector(
+        [this, labels = "queue=\"" + options.name + "\""](std::vector<MetricSample>& samples) {
+            auto stats = impl_->stats();
+            auto add = [&](const char* name, const char* help, MetricType type, double value) {
+                MetricSample sample;
+                sample.name = name;
+                sample.help = help;
+                sample.labels = labels;
+                sample.type = type;
+                sample.value = value;
+                samples.push_back(std::move(sample));
+            };
+            add("x30_queue_messages", "队列中的消息条数", MetricType::GAUGE, static_cast<double>(stats.messages));
+            add("x30_queue_bytes", "队列中消息的估算字节数", MetricType::GAUGE, static_cast<double>(stats.bytes));
+            add("x30_queue_high_water_messages", "队列消息条数峰值", MetricType::GAUGE,
+                static_cast<double>(stats.high_water_messages));
+            add("x30_queue_high_water_bytes", "队列字节数峰值", MetricType::GAUGE,
+                static_cast<double>(stats.high_water_bytes));
+            add("x30_queue_enqueued_total", "入队的消息条数", MetricType::COUNTER,
+                static_cast<double>(stats.enqueued));
+            add("x30_queue_superseded_total", "遥测合并替换的消息条数", MetricType::COUNTER,
+                static_cast<double>(stats.superseded));
+            add("x30_queue_dropped_telemetry_total", "超出预算丢弃的遥测条数", MetricType::COUNTER,
+                static_cast<double>(stats.dropped_telemetry));
+            add("x30_queue_rejected_total", "超出预算拒绝的消息条数", MetricType::COUNTER,
+                static_cast<double>(stats.rejected));
+            add("x30_queue_blocked_total", "超出预算时生产者阻塞次数", MetricType::COUNTER,
+                static_cast<double>(stats.blocked));
+            add("x30_queue_purged_total", "被purge/clear丢弃的消息条数", MetricType::COUNTER,
+                static_cast<double>(stats.purged));
+        });
+}
+
+MessageQueue::~MessageQueue() {
+    MetricsRegistry::getInstance().removeCollector(collector_id_);
+}
+
+bool MessageQueue::push(std::unique_ptr<protocol::IMessage> msg) {
+    auto type = msg ? static_cast<int>(msg->getType()) : -1;
+    bool accepted = impl_->push(std::move(msg));
+    X30_PROBE2(queue_push, type, accepted ? 1 : 0);
+    return accepted;
+}
+
+std::unique_ptr<protocol::IMessage> MessageQueue::pop() {
+    auto msg = impl_->pop();
+    if (msg) {
+        X30_PROBE1(queue_pop, static_cast<int>(msg->getType()));
+    }
     return msg;
 }
 
-void MessageQueue::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    while (!queue_.empty()) {
-        queue_.pop();
+size_t MessageQueue::drain(std::vector<std::unique_ptr<protocol::IMessage>>& out, size_t max) {
+    size_t count = impl_->drain(out, max);
+    for (size_t i = out.size() - count; i < out.size(); ++i) {
+        X30_PROBE1(queue_pop, static_cast<int>(out[i]->getType()));
     }
+    return count;
+}
+
+void MessageQueue::clear() {
+    impl_->clear();
+}
+
+size_t MessageQueue::purge(std::initializer_list<protocol::MessageType> types) {
+    return impl_->purge(types);
 }
 
 void MessageQueue::close() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cv_.notify_all();
-    close_flag_ = true;
+    impl_->close();
+}
+
+MessageQueueStats MessageQueue::stats() const {
+    return impl_->stats();
+}
+
+MessagePriority MessageQueue::classify(protocol::MessageType type) {
+    switch (type) {
+        case protocol::MessageType::PROCEDURE_RESET:
+        case protocol::MessageType::NAVIGATION_TASK_REQ:
+        case protocol::MessageType::CANCEL_TASK_REQ:
+        case protocol::MessageType::QUERY_STATUS_REQ:
+        case protocol::MessageType::GET_REAL_TIME_STATUS_REQ:
+            return MessagePriority::CONTROL;
+        case protocol::MessageType::GET_REAL_TIME_STATUS_RESP:
+            return MessagePriority::TELEMETRY;
+        default:
+            return MessagePriority::MISSION;
+    }
 }
 
 }  // namespace common
@@ -0,0 +1,152 @@
+#include "common/metrics.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace common {
+
+size_t metricShard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t HistogramSnapshot::percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto target = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        cumulative += counts[i];
+        if (cumulative >= target) {
+            return Histogram::bucketUpperBound(i);
+        }
+    }
+    return Histogram::bucketUpperBound(counts.size() - 1);
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.counts.resize(BUCKET_COUNT);
+    // 各格分别读取, 与并发record之间不是原子快照; count取各格之和, 保证与counts一致
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        snapshot.counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.sum = sum_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+size_t Histogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    size_t group = static_cast<size_t>(exponent - SUB_BUCKET_BITS + 1);
+    size_t sub = static_cast<size_t>((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return group * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) {
+    size_t group = index / SUB_BUCKETS;
+    uint64_t sub = index % SUB_BUCKETS;
+    if (group == 0) {
+        return sub;
+    }
+    int shift = static_cast<int>(group) - 1;
+    uint64_t lower = (SUB_BUCKETS + sub) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    return *findOrCreate(name, help, labels, MetricType::COUNTER).counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    return *findOrCreate(name, help, labels, MetricType::GAUGE).gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, const std::string& labels) {
+    return *findOrCreate(name, help, labels, MetricType::HISTOGRAM).histogram;
+}
+
+MetricsRegistry::CollectorId MetricsRegistry::addCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CollectorId id = ++collector_counter_;
+    collectors_.emplace_back(id, std::move(collector));
+    return id;
+}
+
+void MetricsRegistry::removeCollector(CollectorId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collectors_.erase(std::remove_if(collectors_.begin(), collectors_.end(),
+                                     [id](const auto& collector) { return collector.first == id; }),
+                      collectors_.end());
+}
+
+std::vector<MetricSample> MetricsRegistry::collect() const {
+    std::vector<MetricSample> samples;
+    std::lock_guard<std::mutex> lock(mutex_);
+    samples.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        MetricSample sample;
+        sample.name = entry.name;
+        sample.help = entry.help;
+        sample.labels = entry.labels;
+        sample.type = entry.type;
+        switch (entry.type) {
+            case MetricType::COUNTER:
+                sample.value = static_cast<double>(entry.counter->value());
+                break;
+            case MetricType::GAUGE:
+                sample.value = static_cast<double>(entry.gauge->value());
+                break;
+            case MetricType::HISTOGRAM:
+                sample.histogram = entry.histogram->snapshot();
+                break;
+        }
+        samples.push_back(std::move(sample));
+    }
+    for (const auto& collector : collectors_) {
+        collector.second(samples);
+    }
+    return samples;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::findOrCreate(const std::string& name, const std::string& help,
+                                                      const std::string& labels, MetricType type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        if (entry.name == name && entry.labels == labels && entry.type == type) {
+            return entry;
+        }
+    }
+    Entry entry{name, help, labels, type, nullptr, nullptr, nullptr};
+    switch (type) {
+        case MetricType::COUNTER:
+            entry.counter = std::make_unique<Counter>();
+            break;
+        case MetricType::GAUGE:
+            entry.gauge = std::make_unique<Gauge>();
+            break;
+        case MetricType::HISTOGRAM:
+            entry.histogram = std::make_unique<Histogram>();
+            break;
+    }
+    entries_.push_back(std::move(entry));
+    return entries_.back();
+}
+
+}  // namespace common
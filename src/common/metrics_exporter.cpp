@@ -0,0 +1,392 @@
+#include "common/metrics_exporter.hpp"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <numeric>
+#include "common/trace.hpp"
+#include "common/thread_config.hpp"
+#include "common/utils.hpp"
+
+namespace common {
+
+namespace {
+
+constexpr int LISTEN_BACKLOG = 4;
+constexpr size_t MAX_REQUEST_SIZE = 4096;
+// 单个连接的收发超时, 导出线程逐个处理连接, 不能被一个不发请求的客户端卡住
+constexpr int CLIENT_TIMEOUT_MS = 500;
+
+const char* typeName(MetricType type) {
+    switch (type) {
+        case MetricType::COUNTER:
+            return "counter";
+        case MetricType::GAUGE:
+            return "gauge";
+        case MetricType::HISTOGRAM:
+            return "histogram";
+    }
+    return "untyped";
+}
+
+std::string escapeHelp(const std::string& help) {
+    std::string escaped;
+    escaped.reserve(help.size());
+    for (char c : help) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        }
+        else if (c == '\n') {
+            escaped += "\\n";
+        }
+        else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// 拼接已有标签和额外标签, 结果含花括号; 都为空时返回空串
+std::string joinLabels(const std::string& labels, const std::string& extra = "") {
+    if (labels.empty() && extra.empty()) {
+        return "";
+    }
+    if (labels.empty() || extra.empty()) {
+        return "{" + labels + extra + "}";
+    }
+    return "{" + labels + "," + extra + "}";
+}
+
+std::vector<size_t> sortedByName(const std::vector<MetricSample>& samples) {
+    std::vector<size_t> order(samples.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&samples](size_t a, size_t b) { return samples[a].name < samples[b].name; });
+    return order;
+}
+
+void setTimeout(int fd, int option, int timeout_ms) {
+    timeval tv{};
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, option, &tv, sizeof(tv));
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t n = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 已存在的套接字文件是否为异常退出的残留: 连接被拒绝说明没有进程在监听, 能连上说明另一个实例正在使用
+bool isStaleUnixSocket(const sockaddr_un& addr) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    bool stale = connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 && errno == ECONNREFUSED;
+    close(fd);
+    return stale;
+}
+
+std::string httpResponse(const std::string& status, const std::string& content_type, const std::string& body) {
+    return fmt::format("HTTP/1.0 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}", status,
+                       content_type, body.size(), body);
+}
+
+}  // namespace
+
+std::string formatPrometheus(const std::vector<MetricSample>& samples) {
+    std::string text;
+    const std::string* current_name = nullptr;
+    for (size_t index : sortedByName(samples)) {
+        const auto& sample = samples[index];
+        if (current_name == nullptr || *current_name != sample.name) {
+            current_name = &sample.name;
+            text += fmt::format("# HELP {} {}\n# TYPE {} {}\n", sample.name, escapeHelp(sample.help), sample.name,
+                                typeName(sample.type));
+        }
+        if (sample.type != MetricType::HISTOGRAM) {
+            text += fmt::format("{}{} {}\n", sample.name, joinLabels(sample.labels), sample.value);
+            continue;
+        }
+        const auto& histogram = sample.histogram;
+        uint64_t cumulative = 0;
+        // 最后一格收纳所有超出范围的值, 由+Inf表示
+        for (size_t i = 0; i + 1 < histogram.counts.size(); ++i) {
+            cumulative += histogram.counts[i];
+            if ((i + 1) % Histogram::SUB_BUCKETS != 0) {
+                continue;
+            }
+            text += fmt::format("{}_bucket{} {}\n", sample.name,
+                                joinLabels(sample.labels, fmt::format("le=\"{}\"", Histogram::bucketUpperBound(i))),
+                                cumulative);
+        }
+        text += fmt::format("{}_bucket{} {}\n", sample.name, joinLabels(sample.labels, "le=\"+Inf\""), histogram.count);
+        text += fmt::format("{}_sum{} {}\n", sample.name, joinLabels(sample.labels), histogram.sum);
+        text += fmt::format("{}_count{} {}\n", sample.name, joinLabels(sample.labels), histogram.count);
+    }
+    return text;
+}
+
+std::string formatMetricsJson(const std::vector<MetricSample>& samples) {
+    nlohmann::json metrics = nlohmann::json::array();
+    for (const auto& sample : samples) {
+        nlohmann::json metric;
+        metric["name"] = sample.name;
+        metric["labels"] = sample.labels;
+        metric["type"] = typeName(sample.type);
+        if (sample.type == MetricType::HISTOGRAM) {
+            const auto& histogram = sample.histogram;
+            metric["count"] = histogram.count;
+            metric["sum"] = histogram.sum;
+            metric["p50"] = histogram.percentile(0.5);
+            metric["p90"] = histogram.percentile(0.9);
+            metric["p99"] = histogram.percentile(0.99);
+            metric["p999"] = histogram.percentile(0.999);
+            metric["max"] = histogram.percentile(1.0);
+        }
+        else {
+            metric["value"] = sample.value;
+        }
+        metrics.push_back(std::move(metric));
+    }
+    nlohmann::json root;
+    root["timestamp"] = getCurrentTimestamp();
+    root["metrics"] = std::move(metrics);
+    return root.dump(2);
+}
+
+MetricsExporter::MetricsExporter(MetricsExporterOptions options) : options_(std::move(options)) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+void MetricsExporter::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    stop_.reset();
+    openListeners();
+    thread_ = std::thread(&MetricsExporter::exportLoop, this);
+}
+
+void MetricsExporter::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    stop_.requestStop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    closeListeners();
+}
+
+void MetricsExporter::openListeners() {
+    if (!options_.unix_socket_path.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (options_.unix_socket_path.size() >= sizeof(addr.sun_path)) {
+            spdlog::warn("[{}]: [MetricsExporter:WRN]: UNIX套接字路径过长: {}", getCurrentTimestamp(),
+                         options_.unix_socket_path);
+        }
+        else {
+            strncpy(addr.sun_path, options_.unix_socket_path.c_str(), sizeof(addr.sun_path) - 1);
+            // 上次异常退出残留的套接字文件会导致bind失败, 只删除无人监听的套接字,
+            // 不误删同名普通文件, 也不抢占另一个正在运行的实例的套接字
+            struct stat st {};
+            if (lstat(addr.sun_path, &st) == 0 && S_ISSOCK(st.st_mode) && isStaleUnixSocket(addr)) {
+                unlink(addr.sun_path);
+            }
+            int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd >= 0 && bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                listen(fd, LISTEN_BACKLOG) == 0) {
+                listen_fds_.push_back(fd);
+                unix_socket_bound_ = true;
+                spdlog::info("[{}]: [MetricsExporter:INFO]: 指标导出监听UNIX套接字: {}", getCurrentTimestamp(),
+                             options_.unix_socket_path);
+            }
+            else {
+                spdlog::warn("[{}]: [MetricsExporter:WRN]: 监听UNIX套接字失败: {}, {}", getCurrentTimestamp(),
+                             options_.unix_socket_path, strerror(errno));
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+        }
+    }
+
+    if (options_.http_port != 0) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options_.http_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        if (fd >= 0 && setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == 0 &&
+            bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 && listen(fd, LISTEN_BACKLOG) == 0) {
+            listen_fds_.push_back(fd);
+            spdlog::info("[{}]: [MetricsExporter:INFO]: 指标导出监听 http://127.0.0.1:{}/metrics",
+                         getCurrentTimestamp(), options_.http_port);
+        }
+        else {
+            spdlog::warn("[{}]: [MetricsExporter:WRN]: 监听127.0.0.1:{}失败: {}", getCurrentTimestamp(),
+                         options_.http_port, strerror(errno));
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+}
+
+void MetricsExporter::closeListeners() {
+    for (int fd : listen_fds_) {
+        close(fd);
+    }
+    listen_fds_.clear();
+    if (unix_socket_bound_) {
+        unlink(options_.unix_socket_path.c_str());
+        unix_socket_bound_ = false;
+    }
+}
+
+void MetricsExporter::exportLoop() {
+    setupThread("x30-metrics");
+
+    bool snapshot_enabled = !options_.snapshot_path.empty() && options_.snapshot_interval.count() > 0;
+    auto next_snapshot = std::chrono::steady_clock::now() + options_.snapshot_interval;
+
+    std::vector<pollfd> fds;
+    fds.push_back({stop_.fd(), POLLIN, 0});
+    for (int fd : listen_fds_) {
+        fds.push_back({fd, POLLIN, 0});
+    }
+
+    while (running_.load(std::memory_order_acquire)) {
+        int timeout_ms = -1;
+        if (snapshot_enabled) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(next_snapshot -
+                                                                                   std::chrono::steady_clock::now());
+            timeout_ms = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+        }
+        int ready = poll(fds.data(), fds.size(), timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            spdlog::error("[{}]: [MetricsExporter:ERR]: poll失败: {}", getCurrentTimestamp(), strerror(errno));
+            break;
+        }
+        if (ready > 0) {
+            if (fds[0].revents & POLLIN) {
+                break;
+            }
+            for (size_t i = 1; i < fds.size(); ++i) {
+                if (fds[i].revents & POLLIN) {
+                    serve(fds[i].fd);
+                }
+            }
+        }
+        if (snapshot_enabled && std::chrono::steady_clock::now() >= next_snapshot) {
+            writeSnapshot();
+            next_snapshot = std::chrono::steady_clock::now() + options_.snapshot_interval;
+        }
+    }
+
+    // 退出前写最后一次快照, 保留进程结束时的统计
+    if (snapshot_enabled) {
+        writeSnapshot();
+    }
+}
+
+void MetricsExporter::serve(int listen_fd) {
+    int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    setTimeout(fd, SO_RCVTIMEO, CLIENT_TIMEOUT_MS);
+    setTimeout(fd, SO_SNDTIMEO, CLIENT_TIMEOUT_MS);
+
+    // 只需要请求行, 读到头部结束或缓冲区满为止
+    std::string request;
+    char buffer[1024];
+    while (request.size() < MAX_REQUEST_SIZE && request.find("\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+
+    std::string method;
+    std::string path;
+    auto line_end = request.find("\r\n");
+    auto first_space = request.find(' ');
+    if (first_space != std::string::npos && first_space < line_end) {
+        method = request.substr(0, first_space);
+        auto second_space = request.find(' ', first_space + 1);
+        path = request.substr(first_space + 1, std::min(second_space, line_end) - first_space - 1);
+        path = path.substr(0, path.find('?'));
+    }
+
+    std::string response;
+    if (method != "GET") {
+        response = httpResponse("405 Method Not Allowed", "text/plain", "only GET is supported\n");
+    }
+    else if (path == "/metrics") {
+        response = httpResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                                formatPrometheus(MetricsRegistry::getInstance().collect()));
+    }
+    else if (path == "/metrics.json") {
+        response = httpResponse("200 OK", "application/json",
+                                formatMetricsJson(MetricsRegistry::getInstance().collect()));
+    }
+    else if (path == "/trace.json") {
+        response = httpResponse("200 OK", "application/json", Tracer::getInstance().chromeTraceJson());
+    }
+    else {
+        response = httpResponse("404 Not Found", "text/plain", "try /metrics, /metrics.json or /trace.json\n");
+    }
+    sendAll(fd, response);
+    close(fd);
+}
+
+void MetricsExporter::writeSnapshot() {
+    std::string temp_path = options_.snapshot_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file) {
+            spdlog::warn("[{}]: [MetricsExporter:WRN]: 写指标快照失败: {}", getCurrentTimestamp(), temp_path);
+            return;
+        }
+        file << formatMetricsJson(MetricsRegistry::getInstance().collect()) << "\n";
+    }
+    if (std::rename(temp_path.c_str(), options_.snapshot_path.c_str()) != 0) {
+        spdlog::warn("[{}]: [MetricsExporter:WRN]: 替换指标快照失败: {}, {}", getCurrentTimestamp(),
+                     options_.snapshot_path, strerror(errno));
+    }
+}
+
+}  // namespace common
@@ -0,0 +1,34 @@
+#include "common/stop_token.hpp"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cstdint>
+#include <stdexcept>
+
+namespace common {
+
+StopToken::StopToken() : fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    if (fd_ == -1) {
+        throw std::runtime_error("创建停止信号eventfd失败");
+    }
+}
+
+StopToken::~StopToken() {
+    close(fd_);
+}
+
+void StopToken::requestStop() {
+    if (stopped_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    uint64_t one = 1;
+    // eventfd计数不会溢出, 写入只在fd无效时失败, 此时没有可唤醒的等待方
+    [[maybe_unused]] ssize_t n = write(fd_, &one, sizeof(one));
+}
+
+void StopToken::reset() {
+    uint64_t value = 0;
+    [[maybe_unused]] ssize_t n = read(fd_, &value, sizeof(value));
+    stopped_.store(false, std::memory_order_release);
+}
+
+}  // namespace common
@@ -0,0 +1,267 @@
+#include "common/thread_config.hpp"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include "common/metrics.hpp"
+#include "common/utils.hpp"
+
+namespace common {
+
+namespace {
+
+constexpr size_t MAX_THREAD_NAME = 15;  // pthread_setname_np限制为16字节含结尾0
+
+pid_t currentTid() {
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+// 从/proc/self/task/<tid>/stat读取线程CPU时间和最近运行的CPU, 线程已退出时返回false
+bool readThreadStat(pid_t tid, double& cpu_seconds, int& last_cpu) {
+    std::ifstream file("/proc/self/task/" + std::to_string(tid) + "/stat");
+    std::string line;
+    if (!file || !std::getline(file, line)) {
+        return false;
+    }
+    // 第2个字段为括号中的线程名, 可能含空格, 从最后一个')'之后开始按空格切分, 第一个为第3个字段state
+    auto pos = line.rfind(')');
+    if (pos == std::string::npos) {
+        return false;
+    }
+    std::istringstream fields(line.substr(pos + 2));
+    std::vector<std::string> values;
+    std::string value;
+    while (fields >> value) {
+        values.push_back(std::move(value));
+    }
+    // utime为第14个字段, stime为第15个, processor为第39个
+    if (values.size() < 37) {
+        return false;
+    }
+    static const double ticks_per_second = static_cast<double>(sysconf(_SC_CLK_TCK));
+    cpu_seconds = (std::stod(values[11]) + std::stod(values[12])) / ticks_per_second;
+    last_cpu = std::stoi(values[36]);
+    return true;
+}
+
+// 去掉末尾的"-序号", 用于按组匹配配置
+std::string groupName(const std::string& name) {
+    auto pos = name.rfind('-');
+    if (pos == std::string::npos || pos + 1 == name.size()) {
+        return name;
+    }
+    bool numeric = std::all_of(name.begin() + static_cast<std::ptrdiff_t>(pos) + 1, name.end(),
+                               [](char c) { return c >= '0' && c <= '9'; });
+    return numeric ? name.substr(0, pos) : name;
+}
+
+}  // namespace
+
+// 线程退出时注销
+struct ThreadManager::ThreadHandle {
+    pid_t tid = 0;
+    ~ThreadHandle() {
+        if (tid != 0) {
+            ThreadManager::getInstance().unregisterThread(tid);
+        }
+    }
+};
+
+ThreadManager::ThreadManager() {
+    // 首次使用在main线程, 此时的CPU集合即进程允许使用的全部CPU
+    CPU_ZERO(&process_cpus_);
+    sched_getaffinity(0, sizeof(process_cpus_), &process_cpus_);
+    // getpriority合法返回值可以是-1, 用errno区分失败
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, 0);
+    process_nice_ = errno == 0 ? nice : 0;
+    MetricsRegistry::getInstance().addCollector([this](std::vector<MetricSample>& samples) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [tid, info] : threads_) {
+            double cpu_seconds = 0.0;
+            int last_cpu = -1;
+            if (!readThreadStat(tid, cpu_seconds, last_cpu)) {
+                continue;
+            }
+            MetricSample sample;
+            sample.name = "x30_thread_cpu_seconds_total";
+            sample.help = "线程累计CPU时间, 秒";
+            sample.labels = fmt::format("thread=\"{}\",tid=\"{}\"", info.name, tid);
+            sample.type = MetricType::COUNTER;
+            sample.value = cpu_seconds;
+            samples.push_back(std::move(sample));
+        }
+    });
+}
+
+bool ThreadManager::loadConfig(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::unordered_map<std::string, ThreadPolicy> policies;
+    try {
+        nlohmann::json root = nlohmann::json::parse(file);
+        for (const auto& [name, value] : root.at("threads").items()) {
+            ThreadPolicy policy;
+            policy.cpus = value.value("cpus", std::vector<int>{});
+            policy.fifo_priority = value.value("fifo_priority", 0);
+            if (value.contains("nice")) {
+                policy.nice = value.at("nice").get<int>();
+            }
+            policies[name] = std::move(policy);
+        }
+    }
+    catch (const std::exception& e) {
+        spdlog::error("[{}]: [ThreadManager:ERR]: 解析线程配置失败: {}, {}", getCurrentTimestamp(), path, e.what());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 新配置中删掉的线程恢复为默认策略, 不保留旧配置的绑核和nice值
+    std::vector<pid_t> configured;
+    for (const auto& [tid, info] : threads_) {
+        if (findPolicy(info.name) != nullptr) {
+            configured.push_back(tid);
+        }
+    }
+    policies_ = std::move(policies);
+    for (const auto& [tid, info] : threads_) {
+        if (const auto* policy = findPolicy(info.name)) {
+            applyPolicy(tid, info.name, *policy);
+        }
+        else if (std::find(configured.begin(), configured.end(), tid) != configured.end()) {
+            applyPolicy(tid, info.name, ThreadPolicy{});
+        }
+    }
+    spdlog::info("[{}]: [ThreadManager:INFO]: 已加载线程配置: {}, {} 项", getCurrentTimestamp(), path,
+                 policies_.size());
+    return true;
+}
+
+void ThreadManager::setPolicy(const std::string& name, const ThreadPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policies_[name] = policy;
+    for (const auto& [tid, info] : threads_) {
+        if (info.name == name || groupName(info.name) == name) {
+            applyPolicy(tid, info.name, policy);
+        }
+    }
+}
+
+void ThreadManager::setupCurrentThread(const std::string& name) {
+    std::string thread_name = name.substr(0, MAX_THREAD_NAME);
+    pthread_setname_np(pthread_self(), thread_name.c_str());
+
+    thread_local ThreadHandle handle;
+    handle.tid = currentTid();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ThreadInfo info;
+    info.name = thread_name;
+    info.last_sample = std::chrono::steady_clock::now();
+    int last_cpu = -1;
+    readThreadStat(handle.tid, info.last_cpu_seconds, last_cpu);
+    threads_[handle.tid] = std::move(info);
+    if (const auto* policy = findPolicy(thread_name)) {
+        applyPolicy(handle.tid, thread_name, *policy);
+    }
+}
+
+std::vector<ThreadCpuUsage> ThreadManager::cpuUsage() {
+    std::vector<ThreadCpuUsage> usage;
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [tid, info] : threads_) {
+        ThreadCpuUsage item;
+        item.name = info.name;
+        item.tid = tid;
+        if (!readThreadStat(tid, item.cpu_seconds, item.last_cpu)) {
+            continue;
+        }
+        double elapsed = std::chrono::duration<double>(now - info.last_sample).count();
+        if (elapsed > 0.0) {
+            item.cpu_percent = (item.cpu_seconds - info.last_cpu_seconds) / elapsed * 100.0;
+        }
+        info.last_cpu_seconds = item.cpu_seconds;
+        info.last_sample = now;
+        usage.push_back(std::move(item));
+    }
+    std::sort(usage.begin(), usage.end(),
+              [](const ThreadCpuUsage& a, const ThreadCpuUsage& b) { return a.name < b.name; });
+    return usage;
+}
+
+void ThreadManager::logCpuUsage() {
+    for (const auto& item : cpuUsage()) {
+        spdlog::info("[{}]: [ThreadManager:INFO]: 线程 {:<15} tid {:<7} CPU {:6.2f}% 累计 {:.3f}s 最近运行于CPU {}",
+                     getCurrentTimestamp(), item.name, item.tid, item.cpu_percent, item.cpu_seconds, item.last_cpu);
+    }
+}
+
+void ThreadManager::unregisterThread(pid_t tid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.erase(tid);
+}
+
+const ThreadPolicy* ThreadManager::findPolicy(const std::string& name) const {
+    auto it = policies_.find(name);
+    if (it == policies_.end()) {
+        it = policies_.find(groupName(name));
+    }
+    return it == policies_.end() ? nullptr : &it->second;
+}
+
+void ThreadManager::applyPolicy(pid_t tid, const std::string& name, const ThreadPolicy& policy) const {
+    // 新线程继承创建者的绑核和调度策略(如x30-timer由首个添加定时器的线程创建), 配置为空时显式恢复为进程默认
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (policy.cpus.empty()) {
+        cpu_set = process_cpus_;
+    }
+    for (int cpu : policy.cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    if (sched_setaffinity(tid, sizeof(cpu_set), &cpu_set) != 0) {
+        spdlog::warn("[{}]: [ThreadManager:WRN]: 线程 {} 绑定CPU失败: {}", getCurrentTimestamp(), name,
+                     strerror(errno));
+    }
+
+    if (policy.fifo_priority <= 0 && sched_getscheduler(tid) == SCHED_FIFO) {
+        sched_param param{};
+        sched_setscheduler(tid, SCHED_OTHER, &param);
+    }
+
+    // SCHED_FIFO需要CAP_SYS_NICE或RLIMIT_RTPRIO, 失败时保持分时调度继续运行
+    if (policy.fifo_priority > 0) {
+        sched_param param{};
+        param.sched_priority = std::clamp(policy.fifo_priority, sched_get_priority_min(SCHED_FIFO),
+                                          sched_get_priority_max(SCHED_FIFO));
+        if (sched_setscheduler(tid, SCHED_FIFO, &param) != 0) {
+            spdlog::warn("[{}]: [ThreadManager:WRN]: 线程 {} 设置SCHED_FIFO优先级 {} 失败: {}", getCurrentTimestamp(),
+                         name, param.sched_priority, strerror(errno));
+        }
+    }
+    else {
+        // 未设置nice时恢复为进程默认值, 从设置过nice的配置改回默认时不保留旧值
+        int nice = policy.nice.value_or(process_nice_);
+        errno = 0;
+        int current = getpriority(PRIO_PROCESS, static_cast<id_t>(tid));
+        if ((errno != 0 || current != nice) && setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) != 0) {
+            spdlog::warn("[{}]: [ThreadManager:WRN]: 线程 {} 设置nice值 {} 失败: {}", getCurrentTimestamp(), name,
+                         nice, strerror(errno));
+        }
+    }
+}
+
+}  // namespace common
@@ -0,0 +1,267 @@
+#include "common/timer_wheel.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include "common/metrics.hpp"
+#include "common/thread_config.hpp"
+#include "common/utils.hpp"
+
+namespace common {
+
+namespace {
+
+constexpr uint64_t SLOT_MASK = TimerWheel::SLOTS - 1;
+// 第level层覆盖的tick数, 即256^(level+1)
+constexpr uint64_t levelSpan(size_t level) {
+    return uint64_t{1} << (TimerWheel::LEVEL_BITS * (level + 1));
+}
+constexpr uint64_t MAX_DELTA = levelSpan(TimerWheel::LEVELS - 1) - 1;
+
+struct TimerMetrics {
+    Gauge& active;
+    Counter& fired;
+    Histogram& lateness;  // 实际执行时间与计划到期时间之差
+};
+
+TimerMetrics& timerMetrics() {
+    static TimerMetrics metrics{
+        MetricsRegistry::getInstance().gauge("x30_timers_active", "时间轮中的定时器数"),
+        MetricsRegistry::getInstance().counter("x30_timers_fired_total", "定时器回调执行次数"),
+        MetricsRegistry::getInstance().histogram("x30_timer_lateness_ns", "定时器回调相对到期时间的延迟, 纳秒"),
+    };
+    return metrics;
+}
+
+}  // namespace
+
+TimerWheel::TimerWheel() : epoch_(Clock::now()) {
+    timerMetrics();
+}
+
+TimerWheel::~TimerWheel() {
+    shutdown();
+}
+
+TimerWheel::TimerId TimerWheel::schedule(std::chrono::milliseconds delay, Callback callback) {
+    uint64_t delay_ticks = static_cast<uint64_t>(std::max<int64_t>(delay / TICK, 1));
+    return add(delay_ticks, 0, std::move(callback));
+}
+
+TimerWheel::TimerId TimerWheel::schedulePeriodic(std::chrono::milliseconds interval, Callback callback,
+                                                 std::chrono::milliseconds initial_delay) {
+    uint64_t interval_ticks = static_cast<uint64_t>(std::max<int64_t>(interval / TICK, 1));
+    uint64_t delay_ticks = static_cast<uint64_t>(std::max<int64_t>(initial_delay / TICK, 1));
+    return add(delay_ticks, interval_ticks, std::move(callback));
+}
+
+TimerWheel::TimerId TimerWheel::add(uint64_t delay_ticks, uint64_t interval_ticks, Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+        return 0;
+    }
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&TimerWheel::timerLoop, this);
+        thread_id_ = thread_.get_id();
+    }
+    // 没有定时器时线程不推进tick, 先追上当前时间, 避免下次唤醒时逐个空转过期的tick
+    if (timers_.empty() && running_id_ == 0) {
+        current_ = std::max(current_, nowTick());
+    }
+
+    auto timer = std::make_unique<Timer>();
+    timer->id = next_id_++;
+    timer->expiry = std::max(nowTick(), current_) + delay_ticks;
+    timer->interval = interval_ticks;
+    timer->callback = std::move(callback);
+    TimerId id = timer->id;
+    insertLocked(timer.get());
+    bool earlier = timer->expiry < wake_tick_;
+    timers_.emplace(id, std::move(timer));
+    timerMetrics().active.set(static_cast<int64_t>(timers_.size()));
+    if (earlier) {
+        cv_.notify_one();
+    }
+    return id;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return false;
+    }
+    if (id == running_id_) {
+        // 回调执行中, 由定时器线程在回调返回后释放; 其他线程等待回调结束, 回调内取消自身则直接返回
+        bool was_cancelled = running_cancelled_;
+        running_cancelled_ = true;
+        if (std::this_thread::get_id() != thread_id_) {
+            running_cv_.wait(lock, [this, id] { return running_id_ != id; });
+        }
+        return !was_cancelled;
+    }
+    unlink(it->second.get());
+    timers_.erase(it);
+    timerMetrics().active.set(static_cast<int64_t>(timers_.size()));
+    return true;
+}
+
+void TimerWheel::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_) {
+            return;
+        }
+        stopped_ = true;
+        for (auto& [id, timer] : timers_) {
+            unlink(timer.get());
+        }
+        // 正在执行的回调由定时器线程在返回后自行清理
+        for (auto it = timers_.begin(); it != timers_.end();) {
+            it = it->first == running_id_ ? std::next(it) : timers_.erase(it);
+        }
+        cv_.notify_one();
+    }
+    if (thread_.joinable() && std::this_thread::get_id() != thread_id_) {
+        thread_.join();
+    }
+}
+
+size_t TimerWheel::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+uint64_t TimerWheel::nowTick() const {
+    return static_cast<uint64_t>((Clock::now() - epoch_) / TICK);
+}
+
+void TimerWheel::insertLocked(Timer* timer) {
+    // 按距当前tick的差值选层, 层内按到期tick对应的位选格; 差值为0(下放时恰好到期)落在第0层当前格, 本tick内处理
+    uint64_t delta = std::min(timer->expiry - current_, MAX_DELTA);
+    uint64_t expiry = current_ + delta;
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >= levelSpan(level)) {
+        ++level;
+    }
+    Slot& slot = wheels_[level][(expiry >> (LEVEL_BITS * level)) & SLOT_MASK];
+    timer->prev = slot.head.prev;
+    timer->next = &slot.head;
+    slot.head.prev->next = timer;
+    slot.head.prev = timer;
+}
+
+void TimerWheel::unlink(Timer* timer) {
+    if (timer->prev == nullptr) {
+        return;
+    }
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev = timer->next = nullptr;
+}
+
+void TimerWheel::cascadeLocked(size_t level) {
+    Slot& slot = wheels_[level][(current_ >> (LEVEL_BITS * level)) & SLOT_MASK];
+    Timer* timer = slot.head.next;
+    slot.head.prev = slot.head.next = &slot.head;
+    while (timer != &slot.head) {
+        Timer* next = timer->next;
+        insertLocked(timer);
+        timer = next;
+    }
+}
+
+void TimerWheel::advanceLocked(uint64_t target, std::vector<TimerId>& expired) {
+    while (current_ < target) {
+        ++current_;
+        // 低层转满一圈时, 把上一层对应格中的定时器按剩余时间重新放入下层, 先高层后低层
+        for (size_t level = LEVELS - 1; level > 0; --level) {
+            uint64_t low_mask = (uint64_t{1} << (LEVEL_BITS * level)) - 1;
+            if ((current_ & low_mask) == 0) {
+                cascadeLocked(level);
+            }
+        }
+        Slot& slot = wheels_[0][current_ & SLOT_MASK];
+        while (!slot.empty()) {
+            Timer* timer = slot.head.next;
+            unlink(timer);
+            expired.push_back(timer->id);
+        }
+    }
+}
+
+uint64_t TimerWheel::nextWakeTickLocked() const {
+    if (timers_.empty()) {
+        return NO_WAKE;
+    }
+    // 只看第0层到下一次下放为止的格, 最多256格; 都为空时在下放点唤醒
+    uint64_t boundary = (current_ | SLOT_MASK) + 1;
+    for (uint64_t tick = current_ + 1; tick < boundary; ++tick) {
+        if (!wheels_[0][tick & SLOT_MASK].empty()) {
+            return tick;
+        }
+    }
+    return boundary;
+}
+
+void TimerWheel::timerLoop() {
+    setupThread("x30-timer");
+    auto& metrics = timerMetrics();
+    std::vector<TimerId> expired;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_) {
+        wake_tick_ = nextWakeTickLocked();
+        if (wake_tick_ == NO_WAKE) {
+            cv_.wait(lock);
+        }
+        else if (wake_tick_ > nowTick()) {
+            cv_.wait_until(lock, epoch_ + TICK * wake_tick_);
+        }
+        wake_tick_ = NO_WAKE;
+        if (stopped_) {
+            break;
+        }
+
+        expired.clear();
+        advanceLocked(nowTick(), expired);
+        for (TimerId id : expired) {
+            auto it = timers_.find(id);
+            if (it == timers_.end() || stopped_) {
+                continue;  // 同批次中前面的回调取消了它
+            }
+            Timer* timer = it->second.get();
+            running_id_ = id;
+            running_cancelled_ = false;
+            auto due = epoch_ + TICK * timer->expiry;
+            lock.unlock();
+
+            auto lateness = Clock::now() - due;
+            metrics.lateness.record(static_cast<uint64_t>(
+                std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(lateness).count(), 0)));
+            metrics.fired.inc();
+            try {
+                timer->callback();
+            }
+            catch (const std::exception& e) {
+                spdlog::error("[{}]: [TimerWheel:ERR]: 定时器 {} 回调异常: {}", getCurrentTimestamp(), id, e.what());
+            }
+
+            lock.lock();
+            if (running_cancelled_ || timer->interval == 0 || stopped_) {
+                timers_.erase(id);
+                metrics.active.set(static_cast<int64_t>(timers_.size()));
+            }
+            else {
+                // 按计划时间重排; 回调耗时超过周期时跳过错过的次数, 不连续补发
+                timer->expiry += timer->interval;
+                if (timer->expiry <= current_) {
+                    timer->expiry += (current_ - timer->expiry) / timer->interval * timer->interval + timer->interval;
+                }
+                insertLocked(timer);
+            }
+            running_id_ = 0;
+            running_cv_.notify_all();
+        }
+    }
+}
+
+}  // namespace common
@@ -0,0 +1,244 @@
+#include "common/trace.hpp"
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <tuple>
+#include "common/utils.hpp"
+
+namespace common {
+
+namespace {
+
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+uint32_t currentTid() {
+    return static_cast<uint32_t>(syscall(SYS_gettid));
+}
+
+std::string currentThreadName() {
+    char name[16] = {0};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    return name;
+}
+
+}  // namespace
+
+thread_local uint64_t Tracer::current_trace_id_ = 0;
+
+// 线程退出时将缓冲区交还Tracer
+struct Tracer::ThreadHandle {
+    std::shared_ptr<TraceBuffer> buffer;
+    ~ThreadHandle() {
+        if (buffer) {
+            Tracer::getInstance().releaseBuffer(std::move(buffer));
+        }
+    }
+};
+
+TraceBuffer::TraceBuffer(size_t capacity, uint32_t tid, std::string thread_name)
+    : slots_(roundUpPowerOfTwo(std::max<size_t>(capacity, 2))),
+      mask_(slots_.size() - 1),
+      tid_(tid),
+      thread_name_(std::move(thread_name)) {
+}
+
+void TraceBuffer::push(const TraceRecord& record) {
+    uint64_t index = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index & mask_];
+    // 先把序号置0, 读取方在内容写完之前不会接受这个槽位
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(record.name, std::memory_order_relaxed);
+    slot.trace_id.store(record.trace_id, std::memory_order_relaxed);
+    slot.start_ns.store(record.start_ns, std::memory_order_relaxed);
+    slot.end_ns.store(record.end_ns, std::memory_order_relaxed);
+    slot.seq.store(index + 1, std::memory_order_release);
+    head_.store(index + 1, std::memory_order_release);
+}
+
+void TraceBuffer::snapshot(std::vector<TraceRecord>& records) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t begin = head > slots_.size() ? head - slots_.size() : 0;
+    for (uint64_t index = begin; index < head; ++index) {
+        const Slot& slot = slots_[index & mask_];
+        if (slot.seq.load(std::memory_order_acquire) != index + 1) {
+            continue;  // 正在被覆盖
+        }
+        TraceRecord record;
+        record.name = slot.name.load(std::memory_order_relaxed);
+        record.trace_id = slot.trace_id.load(std::memory_order_relaxed);
+        record.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+        record.end_ns = slot.end_ns.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != index + 1) {
+            continue;  // 读取期间被覆盖
+        }
+        records.push_back(record);
+    }
+}
+
+uint32_t TraceBuffer::tid() const {
+    std::lock_guard<std::mutex> lock(name_mutex_);
+    return tid_;
+}
+
+std::string TraceBuffer::threadName() const {
+    std::lock_guard<std::mutex> lock(name_mutex_);
+    return thread_name_;
+}
+
+void TraceBuffer::reassign(uint32_t tid, std::string thread_name) {
+    std::lock_guard<std::mutex> lock(name_mutex_);
+    tid_ = tid;
+    thread_name_ = std::move(thread_name);
+}
+
+Tracer::Tracer() : start_ns_(now()) {
+    configure(TraceOptions{});
+}
+
+void Tracer::configure(const TraceOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer_capacity_ = options.buffer_capacity;
+    }
+    setSampleRate(options.sample_rate);
+}
+
+void Tracer::setSampleRate(double rate) {
+    uint64_t period = 0;
+    if (rate > 0.0) {
+        period = static_cast<uint64_t>(std::max<long long>(1, std::llround(1.0 / std::min(rate, 1.0))));
+    }
+    sample_period_.store(period, std::memory_order_relaxed);
+}
+
+double Tracer::sampleRate() const {
+    uint64_t period = sample_period_.load(std::memory_order_relaxed);
+    return period == 0 ? 0.0 : 1.0 / static_cast<double>(period);
+}
+
+uint64_t Tracer::sample() {
+    uint64_t period = sample_period_.load(std::memory_order_relaxed);
+    if (period == 0) {
+        return 0;
+    }
+    if (sample_counter_.fetch_add(1, std::memory_order_relaxed) % period != 0) {
+        return 0;
+    }
+    return next_trace_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Tracer::record(const char* name, uint64_t trace_id, int64_t start_ns, int64_t end_ns) {
+    if (trace_id == 0) {
+        return;
+    }
+    localBuffer().push(TraceRecord{name, trace_id, start_ns, end_ns});
+}
+
+TraceBuffer& Tracer::localBuffer() {
+    thread_local ThreadHandle handle;
+    if (!handle.buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_buffers_.empty()) {
+            handle.buffer = std::move(free_buffers_.back());
+            free_buffers_.pop_back();
+            handle.buffer->reassign(currentTid(), currentThreadName());
+        }
+        else {
+            handle.buffer = std::make_shared<TraceBuffer>(buffer_capacity_, currentTid(), currentThreadName());
+            buffers_.push_back(handle.buffer);
+        }
+    }
+    return *handle.buffer;
+}
+
+void Tracer::releaseBuffer(std::shared_ptr<TraceBuffer> buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_buffers_.push_back(std::move(buffer));
+}
+
+std::string Tracer::chromeTraceJson() const {
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers = buffers_;
+    }
+
+    auto pid = static_cast<int>(getpid());
+    auto toMicros = [this](int64_t ns) { return static_cast<double>(ns - start_ns_) / 1000.0; };
+    nlohmann::json events = nlohmann::json::array();
+    events.push_back({{"name", "process_name"}, {"ph", "M"}, {"pid", pid}, {"args", {{"name", "x30_inspection"}}}});
+
+    // (追踪id, 开始时间, tid), 用于生成flow事件
+    std::vector<std::tuple<uint64_t, int64_t, uint32_t>> flow_points;
+    std::vector<TraceRecord> records;
+    for (const auto& buffer : buffers) {
+        records.clear();
+        buffer->snapshot(records);
+        uint32_t tid = buffer->tid();
+        events.push_back({{"name", "thread_name"},
+                          {"ph", "M"},
+                          {"pid", pid},
+                          {"tid", tid},
+                          {"args", {{"name", buffer->threadName()}}}});
+        for (const auto& record : records) {
+            events.push_back({{"name", record.name},
+                              {"cat", "x30"},
+                              {"ph", "X"},
+                              {"ts", toMicros(record.start_ns)},
+                              {"dur", static_cast<double>(record.end_ns - record.start_ns) / 1000.0},
+                              {"pid", pid},
+                              {"tid", tid},
+                              {"args", {{"trace_id", record.trace_id}}}});
+            flow_points.emplace_back(record.trace_id, record.start_ns, tid);
+        }
+    }
+
+    // 同一追踪id的span按开始时间串联: 第一个为s, 中间为t, 最后一个为f
+    std::sort(flow_points.begin(), flow_points.end());
+    for (size_t i = 0; i < flow_points.size(); ++i) {
+        auto [trace_id, start_ns, tid] = flow_points[i];
+        bool first = i == 0 || std::get<0>(flow_points[i - 1]) != trace_id;
+        bool last = i + 1 == flow_points.size() || std::get<0>(flow_points[i + 1]) != trace_id;
+        if (first && last) {
+            continue;
+        }
+        nlohmann::json flow{{"name", "message"}, {"cat", "x30"},  {"id", trace_id},
+                            {"ts", toMicros(start_ns)}, {"pid", pid}, {"tid", tid}};
+        flow["ph"] = first ? "s" : (last ? "f" : "t");
+        if (last) {
+            flow["bp"] = "e";
+        }
+        events.push_back(std::move(flow));
+    }
+
+    nlohmann::json root;
+    root["traceEvents"] = std::move(events);
+    root["displayTimeUnit"] = "ms";
+    return root.dump();
+}
+
+bool Tracer::exportChromeTrace(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        spdlog::error("[{}]: [Tracer:ERR]: 打开追踪导出文件失败: {}", getCurrentTimestamp(), path);
+        return false;
+    }
+    file << chromeTraceJson();
+    spdlog::info("[{}]: [Tracer:INFO]: 追踪已导出: {}", getCurrentTimestamp(), path);
+    return true;
+}
+
+}  // namespace common
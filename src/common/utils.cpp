@@ -49,13 +49,15 @@ std::vector<protocol::NavigationPoint> loadDefaultNavigationPoints(const std::st
     return points;
 }
 
-// 辅助函数：加载默认导航点
-std::vector<protocol::NavigationPoint> loadNavigationPoints() {
+std::string getConfigPath(const std::string& fileName) {
     std::filesystem::path exePath = std::filesystem::canonical("/proc/self/exe");
     std::filesystem::path projectRoot = exePath.parent_path().parent_path();
-    std::filesystem::path configPath = projectRoot / "config" / "default_params.json";
+    return (projectRoot / "config" / fileName).string();
+}
 
-    static std::vector<protocol::NavigationPoint> points = loadDefaultNavigationPoints(configPath.string());
+// 辅助函数：加载默认导航点
+std::vector<protocol::NavigationPoint> loadNavigationPoints() {
+    static std::vector<protocol::NavigationPoint> points = loadDefaultNavigationPoints(getConfigPath("default_params.json"));
     return points;
 }
 
@@ -1,3 +1,7 @@
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
 #include <chrono>
 #include <iostream>
 #include <ostream>
@@ -7,11 +11,20 @@
 #include "protocol/x30_protocol.hpp"
 // #include <fmt/core.h>
 #include "common/logger.hpp"
+#include "common/metrics_exporter.hpp"
+#include "common/stop_token.hpp"
+#include "common/thread_config.hpp"
+#include "common/timer_wheel.hpp"
+#include "common/trace.hpp"
 #include "common/utils.hpp"
 // #include "common/Logger.hpp"
 namespace x30 {
 
-std::atomic<bool> program_running_(true);
+// 进程停止信号: quit命令、重连耗尽、SIGINT/SIGTERM都通过它让命令循环立即返回
+common::StopToken program_stop_;
+// trace命令的导出文件, 可在chrome://tracing或ui.perfetto.dev中打开
+const std::string TRACE_EXPORT_PATH = "logs/x30_trace.json";
+
 // 命令处理结果
 enum class CommandResult { SUCCESS, CONTINUE, EXIT };
 
@@ -24,19 +37,18 @@ public:
     ~InspectionApp() = default;
 
     // 初始化应用程序
-    bool initialize(const std::string& host, uint16_t port) {
+    bool initialize(const std::string& host, uint16_t port, const std::string& capture_path) {
         setupEventHandlers();
+        metrics_exporter_.start();
 
-        if (!system_->initialize(host, port)) {
+        if (!system_->initialize(host, port, capture_path)) {
             spdlog::error("[{}]: [InspectionApp:ERR]: 系统初始化失败", common::getCurrentTimestamp());
             // std::cout << "系统初始化失败\n";
             return false;
         }
 
-        spdlog::info("[{}]: [InspectionApp:INFO]: 系统已初始化，等待连接...", common::getCurrentTimestamp());
-        // std::cout << "系统已初始化，等待连接...\n";
-        waitForConnection();
-        spdlog::info("[{}]: [InspectionApp:INFO]: 已连接到设备", common::getCurrentTimestamp());
+        // initialize在连接握手完成后才返回, 连接失败时直接返回false
+        spdlog::info("[{}]: [InspectionApp:INFO]: 系统已初始化，已连接到设备", common::getCurrentTimestamp());
         // std::cout << "已连接到设备\n";
 
         return true;
@@ -47,12 +59,10 @@ public:
         printHelp();
         std::string command;
 
-        while (program_running_) {
+        while (!program_stop_.stopRequested()) {
             spdlog::info("[{}]: [InspectionApp:INFO]: 请输入命令:\n", common::getCurrentTimestamp());
             // std::cout << "\n请输入命令:\n";
-            std::getline(std::cin, command);
-
-            if (not program_running_) {
+            if (!readCommand(command)) {
                 break;
             }
             auto result = handleCommand(command);
@@ -64,32 +74,85 @@ public:
         // 程序结束，关闭系统
         system_->shutdown();
         system_.reset();
+        metrics_exporter_.stop();
         spdlog::info("[{}]: [InspectionApp:INFO]: 程序结束", common::getCurrentTimestamp());
     }
 
 private:
+    // 同时等待标准输入和停止信号, 读到一行返回true; 收到停止信号或标准输入关闭时返回false
+    // 不使用std::getline: 它阻塞在read中, 重连耗尽或收到SIGTERM时无法退出
+    bool readCommand(std::string& command) {
+        while (!program_stop_.stopRequested()) {
+            auto pos = input_buffer_.find('\n');
+            if (pos != std::string::npos) {
+                command = input_buffer_.substr(0, pos);
+                input_buffer_.erase(0, pos + 1);
+                if (!command.empty() && command.back() == '\r') {
+                    command.pop_back();
+                }
+                return true;
+            }
+
+            pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {program_stop_.fd(), POLLIN, 0}};
+            if (::poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (fds[1].revents & POLLIN) {
+                return false;
+            }
+            if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[256];
+                ssize_t n = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+                if (n > 0) {
+                    input_buffer_.append(buffer, static_cast<size_t>(n));
+                }
+                else if (n == 0) {
+                    // 标准输入关闭(如管道输入结束)按quit处理, 末尾没有换行的最后一行仍然执行
+                    if (input_buffer_.empty()) {
+                        return false;
+                    }
+                    command = std::move(input_buffer_);
+                    input_buffer_.clear();
+                    return true;
+                }
+                else if (errno != EINTR && errno != EAGAIN) {
+                    return false;
+                }
+            }
+        }
+        return false;
+    }
+
     // 设置事件处理器
     void setupEventHandlers() {
-        // 订阅网络错误事件
-        common::EventBus::getInstance().subscribe<common::NetworkErrorEvent>([](const std::shared_ptr<common::Event>&) {
-            // auto errorEvent = std::static_pointer_cast<common::NetworkErrorEvent>(event);
-            // spdlog::error("[{}]: 网络错误: {}, 请检查网络连接, 程序需要重新启动", common::getCurrentTimestamp(), errorEvent->message);
-            // std::cout << fmt::format("[{}]: 网络错误: {}, 请检查网络连接, 程序需要重新启动", common::getCurrentTimestamp(), errorEvent->message) << std::endl;
-            // common::Logger::getInstance().error(__FILE__, __LINE__, "网络错误: {}, 请检查网络连接, 程序需要重新启动", errorEvent->message);
-            program_running_ = false;
-        });
+        // 订阅网络重连失败事件, 网络错误由NetworkModelManager自动重连
+        common::EventBus::getInstance().subscribe<common::NetworkReconnectFailedEvent>(
+            [](const common::NetworkReconnectFailedEvent&) {
+                // auto errorEvent = std::static_pointer_cast<common::NetworkErrorEvent>(event);
+                // spdlog::error("[{}]: 网络错误: {}, 请检查网络连接, 程序需要重新启动", common::getCurrentTimestamp(), errorEvent->message);
+                // std::cout << fmt::format("[{}]: 网络错误: {}, 请检查网络连接, 程序需要重新启动", common::getCurrentTimestamp(), errorEvent->message) << std::endl;
+                // common::Logger::getInstance().error(__FILE__, __LINE__, "网络错误: {}, 请检查网络连接, 程序需要重新启动", errorEvent->message);
+                program_stop_.requestStop();
+            });
 
         // 订阅导航任务事件
-        common::EventBus::getInstance().subscribe<common::NavigationTaskEvent>([](const std::shared_ptr<
-                                                                                   common::Event>&) {
+        common::EventBus::getInstance().subscribe<common::NavigationTaskEvent>([](const common::NavigationTaskEvent&) {
             // auto taskEvent = std::static_pointer_cast<common::NavigationTaskEvent>(event);
             // spdlog::info("[{}]: 导航任务执行状态: {}", common::getCurrentTimestamp(), taskEvent->status);
             // std::cout << fmt::format("[{}]: 导航任务执行状态: {}", common::getCurrentTimestamp(), taskEvent->status) << std::endl;
             // common::Logger::getInstance().info(__FILE__, __LINE__, "导航任务执行状态: {}", taskEvent->status);
         });
 
+        // 状态查询/实时状态属于遥测, 异步投递, 避免处理器拖慢消息处理线程
+        common::EventBus::SubscribeOptions telemetry_options;
+        telemetry_options.mode = common::EventBus::DeliveryMode::ASYNC;
+        telemetry_options.overflow_policy = common::EventBus::MailboxOverflowPolicy::DROP_OLDEST;
+
         // 订阅状态查询消息响应事件
-        common::EventBus::getInstance().subscribe<common::QueryStatusEvent>([](const std::shared_ptr<common::Event>&) {
+        common::EventBus::getInstance().subscribe<common::QueryStatusEvent>([](const common::QueryStatusEvent&) {
             // auto queryEvent = std::static_pointer_cast<common::QueryStatusEvent>(event);
             // if (queryEvent->status == protocol::NavigationStatus::EXECUTING) {
             //     static int lastValue = 0;
@@ -115,21 +178,22 @@ private:
             //     //     common::getCurrentTimestamp(), queryEvent->status) << std::endl;
             //     // common::Logger::getInstance().info(__FILE__, __LINE__, "查询到导航任务执行完成, status: {}", queryEvent->status);
             // }
-        });
+        }, telemetry_options);
 
         // 订阅实时状态消息响应事件
-        common::EventBus::getInstance().subscribe<common::GetRealTimeStatusEvent>([](const std::shared_ptr<
-                                                                                      common::Event>&) {
-            // auto realTimeEvent = std::static_pointer_cast<common::GetRealTimeStatusEvent>(event);
-            // spdlog::info("[{}]: 当前位置坐标: [{}, {}, {}]，累计里程数：{}, 机器人定位状态: {}",
-            //     common::getCurrentTimestamp(), realTimeEvent->posX, realTimeEvent->posY, realTimeEvent->posZ, realTimeEvent->sumOdom, realTimeEvent->location);
-            // std::cout << fmt::format("[{}]: 当前位置坐标: [{}, {}, {}]，累计里程数：{}, 机器人定位状态: {}",
-            // common::getCurrentTimestamp(), realTimeEvent->posX, realTimeEvent->posY, realTimeEvent->posZ, realTimeEvent->sumOdom, realTimeEvent->location) << std::endl;
-            // common::Logger::getInstance().info(__FILE__, __LINE__, "当前位置坐标: [{}, {}, {}]，累计里程数：{}, 机器人定位状态: {}", realTimeEvent->posX, realTimeEvent->posY, realTimeEvent->posZ, realTimeEvent->sumOdom, realTimeEvent->location);
-        });
+        common::EventBus::getInstance().subscribe<common::GetRealTimeStatusEvent>(
+            [](const common::GetRealTimeStatusEvent&) {
+                // auto realTimeEvent = std::static_pointer_cast<common::GetRealTimeStatusEvent>(event);
+                // spdlog::info("[{}]: 当前位置坐标: [{}, {}, {}]，累计里程数：{}, 机器人定位状态: {}",
+                //     common::getCurrentTimestamp(), realTimeEvent->posX, realTimeEvent->posY, realTimeEvent->posZ, realTimeEvent->sumOdom, realTimeEvent->location);
+                // std::cout << fmt::format("[{}]: 当前位置坐标: [{}, {}, {}]，累计里程数：{}, 机器人定位状态: {}",
+                // common::getCurrentTimestamp(), realTimeEvent->posX, realTimeEvent->posY, realTimeEvent->posZ, realTimeEvent->sumOdom, realTimeEvent->location) << std::endl;
+                // common::Logger::getInstance().info(__FILE__, __LINE__, "当前位置坐标: [{}, {}, {}]，累计里程数：{}, 机器人定位状态: {}", realTimeEvent->posX, realTimeEvent->posY, realTimeEvent->posZ, realTimeEvent->sumOdom, realTimeEvent->location);
+            },
+            telemetry_options);
 
         // 订阅错误事件
-        common::EventBus::getInstance().subscribe<common::ErrorEvent>([](const std::shared_ptr<common::Event>&) {
+        common::EventBus::getInstance().subscribe<common::ErrorEvent>([](const common::ErrorEvent&) {
             // auto errorEvent = std::static_pointer_cast<common::ErrorEvent>(event);
             // spdlog::error("[{}]: 错误 [{}]: {}", common::getCurrentTimestamp(), errorEvent->code, errorEvent->message);
             // std::cout << fmt::format("[{}]: 错误 [{}]: {}", common::getCurrentTimestamp(), errorEvent->code, errorEvent->message) << std::endl;
@@ -137,13 +201,6 @@ private:
         });
     }
 
-    // 等待连接建立
-    void waitForConnection() {
-        while (!system_->isConnected()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-    }
-
     // 处理用户命令
     CommandResult handleCommand(const std::string& command) {
 
@@ -151,6 +208,14 @@ private:
             system_->handleCommand(command);
             return CommandResult::CONTINUE;
         }
+        else if (command == "threads") {
+            common::ThreadManager::getInstance().logCpuUsage();
+            return CommandResult::CONTINUE;
+        }
+        else if (command == "trace") {
+            common::Tracer::getInstance().exportChromeTrace(TRACE_EXPORT_PATH);
+            return CommandResult::CONTINUE;
+        }
         else if (command == "quit") {
             return CommandResult::EXIT;
         }
@@ -170,7 +235,8 @@ private:
     static void printHelp() {
         spdlog::info(
             "[{}]: [InspectionApp:INFO]: 可用命令：\n1. start - 开始巡检任务\n2. cancel - 取消巡检任务\n3. status - "
-            "查询状态\n4. help - 显示此帮助信息\n5. quit - 退出程序\n",
+            "查询状态\n4. trace - 导出消息追踪(Chrome trace JSON)\n5. threads - 查看各线程CPU占用\n6. help - "
+            "显示此帮助信息\n7. quit - 退出程序\n",
             common::getCurrentTimestamp());
         // std::cout << "可用命令：\n"
         //           << "1. start - 开始巡检任务\n"
@@ -182,27 +248,40 @@ private:
 
 private:
     std::unique_ptr<application::X30InspectionSystem> system_;
+    std::string input_buffer_;  // 标准输入中尚未组成完整一行的部分
+    // 本地指标导出, 供本机采集代理拉取
+    common::MetricsExporter metrics_exporter_;
 };
 
-}  // namespace x30
+// SIGINT/SIGTERM(如滚动重启时由服务管理器发出)按quit处理, 走正常的关闭流程
+void handleStopSignal(int) {
+    program_stop_.requestStop();
+}
 
-int main(int argc, char* argv[]) {
-    // 初始化日志
-    common::Logger::init();
+void installStopSignals() {
+    struct sigaction action {};
+    action.sa_handler = handleStopSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
 
+int runApp(int argc, char* argv[]) {
     try {
-        if (argc != 3) {
-            spdlog::error("[{}]: 用法: {} <host> <port>", common::getCurrentTimestamp(), argv[0]);
+        if (argc != 3 && argc != 4) {
+            spdlog::error("[{}]: 用法: {} <host> <port> [capture_file]", common::getCurrentTimestamp(), argv[0]);
             // std::cout << "用法: " << argv[0] << " <host> <port>\n";
             // common::Logger::getInstance().error(__FILE__, __LINE__, "用法: {} <host> <port>", argv[0]);
             return 1;
         }
 
-        x30::InspectionApp app;
+        InspectionApp app;
         std::string host = argv[1];
         uint16_t port = static_cast<uint16_t>(std::stoi(argv[2]));
+        std::string capture_path = argc == 4 ? argv[3] : "";
 
-        if (!app.initialize(host, port)) {
+        if (!app.initialize(host, port, capture_path)) {
             spdlog::error("[{}]: 初始化失败", common::getCurrentTimestamp());
             // common::Logger::getInstance().error(__FILE__, __LINE__, "初始化失败");
             return 1;
@@ -216,3 +295,24 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 }
+
+}  // namespace x30
+
+int main(int argc, char* argv[]) {
+    // 初始化日志
+    common::setupThread("x30-main");
+    common::Logger::init();
+    // 线程命名/绑核/实时优先级配置, 文件不存在时所有线程使用默认调度
+    common::ThreadManager::getInstance().loadConfig(common::getConfigPath("threads.json"));
+    // 默认每100条消息追踪一条, 开销可长期开启
+    common::Tracer::getInstance().configure(common::TraceOptions{});
+    x30::installStopSignals();
+
+    int exit_code = x30::runApp(argc, argv);
+
+    // 应用各组件已按顺序停止, 最后停止共享的定时器线程并写完日志, 不依赖静态对象的析构顺序
+    common::TimerWheel::getInstance().shutdown();
+    spdlog::info("[{}]: [InspectionApp:INFO]: 进程退出, 退出码 {}", common::getCurrentTimestamp(), exit_code);
+    common::Logger::shutdown();
+    return exit_code;
+}
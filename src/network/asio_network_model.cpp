@@ -3,12 +3,78 @@
 #include <spdlog/spdlog.h>
 #include "common/event_bus.hpp"
 #include "common/message_queue.hpp"
+#include "common/probes.hpp"
+#include "common/thread_config.hpp"
+#include "common/trace.hpp"
 #include "common/utils.hpp"
 namespace network {
+
+namespace {
+// 相邻两个地址发起连接的间隔(RFC 8305 Connection Attempt Delay)
+constexpr std::chrono::milliseconds CONNECT_ATTEMPT_DELAY{250};
+// 整个连接过程的超时时间
+constexpr std::chrono::milliseconds CONNECT_TIMEOUT{5000};
+
+// 保持解析结果的优先顺序, 在IPv6与IPv4之间交替(RFC 8305)
+std::vector<boost::asio::ip::tcp::endpoint> interleaveEndpoints(
+    const boost::asio::ip::tcp::resolver::results_type& results) {
+    std::vector<boost::asio::ip::tcp::endpoint> primary;
+    std::vector<boost::asio::ip::tcp::endpoint> secondary;
+    for (const auto& entry : results) {
+        auto endpoint = entry.endpoint();
+        if (primary.empty() || primary.front().protocol() == endpoint.protocol()) {
+            primary.push_back(endpoint);
+        }
+        else {
+            secondary.push_back(endpoint);
+        }
+    }
+
+    std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+    for (size_t i = 0; i < std::max(primary.size(), secondary.size()); ++i) {
+        if (i < primary.size()) {
+            endpoints.push_back(primary[i]);
+        }
+        if (i < secondary.size()) {
+            endpoints.push_back(secondary[i]);
+        }
+    }
+    return endpoints;
+}
+}  // namespace
+
+// 一次连接竞速的状态, 仅在strand_中访问
+struct AsioNetworkModel::ConnectRace {
+    explicit ConnectRace(boost::asio::io_context& io_context) : attempt_timer(io_context), deadline_timer(io_context) {
+    }
+
+    // 结束竞速, 关闭尚未完成的连接尝试
+    void cancel() {
+        done = true;
+        attempt_timer.cancel();
+        deadline_timer.cancel();
+        for (auto& socket : sockets) {
+            boost::system::error_code ec;
+            socket->close(ec);
+        }
+        sockets.clear();
+    }
+
+    std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+    size_t next = 0;
+    size_t failed = 0;
+    bool done = false;
+    boost::asio::steady_timer attempt_timer;
+    boost::asio::steady_timer deadline_timer;
+    std::vector<std::shared_ptr<boost::asio::ip::tcp::socket>> sockets;
+};
 AsioNetworkModel::AsioNetworkModel(common::MessageQueue& message_queue)
     : io_context_(),
-      io_thread_([this]() { io_context_.run(); }),
       work_(io_context_),
+      io_thread_([this]() {
+          common::setupThread("x30-asio");
+          io_context_.run();
+      }),
       socket_(io_context_),
       strand_(io_context_.get_executor()),
       message_queue_(message_queue) {
@@ -16,55 +82,179 @@ AsioNetworkModel::AsioNetworkModel(common::MessageQueue& message_queue)
 
 AsioNetworkModel::~AsioNetworkModel() {
     disconnect();
+
+    // 停止IO上下文
+    io_context_.stop();
+    if (io_thread_.joinable()) {
+        io_thread_.join();
+    }
 }
 
 bool AsioNetworkModel::connect(const std::string& host, uint16_t port) {
+    if (connected_ || connecting_) {
+        return false;
+    }
+    beginConnection();
+
+    boost::system::error_code ec;
     boost::asio::ip::tcp::resolver resolver(io_context_);
-    auto endpoints = resolver.resolve(host, std::to_string(port));
-    return doConnect(*endpoints.begin());
+    auto results = resolver.resolve(host, std::to_string(port), ec);
+    if (ec || results.empty()) {
+        spdlog::error("[{}]: [AsioNetworkModel:ERR]: 地址解析失败: {}, {}", common::getCurrentTimestamp(), host,
+                      ec.message());
+        return false;
+    }
+
+    auto race = std::make_shared<ConnectRace>(io_context_);
+    race->endpoints = interleaveEndpoints(results);
+    {
+        std::lock_guard<std::mutex> lock(race_mutex_);
+        current_race_ = race;
+    }
+    connecting_ = true;
+
+    // 各地址错开发起连接, 采用最先完成握手的连接
+    boost::asio::post(strand_, [this, self = shared_from_this(), race]() {
+        race->deadline_timer.expires_after(CONNECT_TIMEOUT);
+        race->deadline_timer.async_wait(
+            boost::asio::bind_executor(strand_, [this, self, race](const boost::system::error_code& error) {
+                if (!error && !race->done) {
+                    race->cancel();
+                    handleError(fmt::format("连接超时"));
+                }
+            }));
+        startAttempt(race);
+    });
+    return true;
 }
 
 void AsioNetworkModel::disconnect() {
-    // 1. 首先取消所有待处理的异步操作
-    if (socket_.is_open()) {
-        boost::system::error_code ec;
-        socket_.cancel(ec);  // 取消所有待处理的异步操作
-        socket_.close(ec);   // 关闭socket
-    }
+    // 取消所有待处理的异步操作并关闭socket, IO上下文保持运行以便重连
+    connected_ = false;
+    connecting_ = false;
 
-    // 2. 停止IO上下文
-    io_context_.stop();
+    std::shared_ptr<ConnectRace> race;
+    {
+        std::lock_guard<std::mutex> lock(race_mutex_);
+        race = std::move(current_race_);
+    }
+    // socket_与竞速状态只在strand_中访问, 关闭也投递到strand_执行, 避免与正在执行的读写回调竞争
+    auto close = [this, race]() {
+        // 投递之前已在strand_中完成的握手可能又置位了连接状态
+        connected_ = false;
+        connecting_ = false;
+        if (race) {
+            race->cancel();
+        }
+        if (socket_.is_open()) {
+            boost::system::error_code ec;
+            socket_.cancel(ec);  // 取消所有待处理的异步操作
+            socket_.close(ec);   // 关闭socket
+        }
+    };
+    // IO线程中(如handleError)直接执行, 投递后等待会死锁
+    if (std::this_thread::get_id() == io_thread_.get_id()) {
+        close();
+        return;
+    }
+    // 等待关闭完成, 返回后可以立即发起重连
+    std::promise<void> closed;
+    auto future = closed.get_future();
+    boost::asio::post(strand_, [&close, &closed]() {
+        close();
+        closed.set_value();
+    });
+    future.wait();
 }
 
 bool AsioNetworkModel::isConnected() const {
-    return socket_.is_open();
+    return connected_;
 }
 
-void AsioNetworkModel::sendMessage(const protocol::IMessage& message) {
-    auto self = shared_from_this();
-    boost::asio::post(strand_, [this, self, msg = message.serialize()]() {
+SendResult AsioNetworkModel::sendMessage(const protocol::IMessage& message) {
+    // 入队在调用线程完成, 以便同步返回背压信号; 未连接时保留在队列中, 连接建立后统一发送
+    std::string frame = message.serialize();
+    SendResult result;
+    {
         std::lock_guard<std::mutex> lock(write_queue_mutex_);
-        bool write_in_progress = !write_queue_.empty();
-        write_queue_.push(std::move(msg));
-        if (!write_in_progress) {
-            doWrite();
-        }
-    });
+        result = write_queue_.push(message.getType(), std::move(frame), common::Tracer::currentTraceId());
+    }
+
+    if (result == SendResult::REJECTED) {
+        spdlog::warn("[{}]: [AsioNetworkModel:WRN]: 发送队列已满, 丢弃消息: {}", common::getCurrentTimestamp(),
+                     static_cast<int>(message.getType()));
+        return result;
+    }
+
+    boost::asio::post(strand_, [this, self = shared_from_this()]() { doWrite(); });
+    return result;
 }
 
-bool AsioNetworkModel::doConnect(const boost::asio::ip::tcp::endpoint& endpoint) {
+void AsioNetworkModel::startAttempt(const std::shared_ptr<ConnectRace>& race) {
+    if (race->done || race->next >= race->endpoints.size()) {
+        return;
+    }
+
     auto self = shared_from_this();
-    socket_.async_connect(endpoint,
-                          boost::asio::bind_executor(strand_, [this, self](const boost::system::error_code& error) {
-                              if (!error) {
-                                  doRead();
-                              }
-                              else {
-                                  // handleError(fmt::format("连接失败: {}", error.message()));
-                                  handleError(fmt::format("连接失败: {}", error.message()));
-                              }
+    auto endpoint = race->endpoints[race->next++];
+    auto socket = std::make_shared<boost::asio::ip::tcp::socket>(io_context_);
+    race->sockets.push_back(socket);
+    socket->async_connect(endpoint, boost::asio::bind_executor(strand_, [this, self, race, socket, endpoint](
+                                                                            const boost::system::error_code& error) {
+                              onAttemptComplete(race, socket, endpoint, error);
                           }));
-    return true;
+
+    // 当前尝试迟迟没有结果, 并行发起下一个地址的连接
+    if (race->next < race->endpoints.size()) {
+        race->attempt_timer.expires_after(CONNECT_ATTEMPT_DELAY);
+        race->attempt_timer.async_wait(
+            boost::asio::bind_executor(strand_, [this, self, race](const boost::system::error_code& error) {
+                if (!error) {
+                    startAttempt(race);
+                }
+            }));
+    }
+}
+
+void AsioNetworkModel::onAttemptComplete(const std::shared_ptr<ConnectRace>& race,
+                                         const std::shared_ptr<boost::asio::ip::tcp::socket>& socket,
+                                         const boost::asio::ip::tcp::endpoint& endpoint,
+                                         const boost::system::error_code& error) {
+    if (race->done) {
+        return;
+    }
+
+    if (!error) {
+        race->sockets.erase(std::remove(race->sockets.begin(), race->sockets.end(), socket), race->sockets.end());
+        race->cancel();
+        {
+            std::lock_guard<std::mutex> lock(race_mutex_);
+            if (current_race_ == race) {
+                current_race_.reset();
+            }
+        }
+
+        socket_ = std::move(*socket);
+        connected_ = true;
+        connecting_ = false;
+        spdlog::info("[{}]: [AsioNetworkModel:INFO]: 已连接到 {}", common::getCurrentTimestamp(),
+                     fmt::format("{}:{}", endpoint.address().to_string(), endpoint.port()));
+        doRead();
+        // 断线期间积压的消息在重连后继续发送
+        doWrite();
+        notifyConnectResult(true);
+        return;
+    }
+
+    spdlog::warn("[{}]: [AsioNetworkModel:WRN]: 连接{}失败: {}", common::getCurrentTimestamp(),
+                 endpoint.address().to_string(), error.message());
+    if (++race->failed == race->endpoints.size()) {
+        race->cancel();
+        handleError(fmt::format("连接失败: 所有地址均不可达"));
+        return;
+    }
+    // 该地址失败, 立即尝试下一个地址
+    startAttempt(race);
 }
 
 void AsioNetworkModel::doRead() {
@@ -85,6 +275,8 @@ void AsioNetworkModel::doRead() {
                     handleError(fmt::format("协议头同步字节错误"));
                     return;
                 }
+                // 与epoll模型一致, socket_read覆盖从收到协议头到读完消息体
+                read_start_ns_ = common::Tracer::now();
 
                 // 2. 读取消息体
                 message_buffer_.resize(current_header_.length);
@@ -98,6 +290,9 @@ void AsioNetworkModel::doRead() {
                             return;
                         }
                         // 3. 处理完整消息
+                        recordFrame(CaptureDirection::INBOUND, &current_header_, sizeof(current_header_),
+                                    message_buffer_.data(), message_buffer_.size());
+                        X30_PROBE1(frame_received, message_buffer_.size());
                         processMessage(message_buffer_);
 
                         // 4. 继续读取下一条消息
@@ -107,18 +302,49 @@ void AsioNetworkModel::doRead() {
 }
 
 void AsioNetworkModel::handleError(std::string_view error_msg) {
-    spdlog::error("[{}]: 网络错误: {}, 请检查网络连接, 程序需要重新启动", common::getCurrentTimestamp(), error_msg);
-    auto error_event = std::make_shared<common::NetworkErrorEvent>();
-    error_event->message = std::string{error_msg};
+    // 只有第一次出错时关闭连接并通知, 避免重复触发重连
+    // 编号在判断状态之前读取: 通过判断说明出错时尚未断开, 新连接的connect还未递增编号
+    uint64_t connection_id = connectionId();
+    bool was_connecting = connecting_.exchange(false);
+    if (!connected_.exchange(false) && !was_connecting) {
+        return;
+    }
+    spdlog::error("[{}]: 网络错误: {}, 连接已断开", common::getCurrentTimestamp(), error_msg);
+    if (was_connecting) {
+        notifyConnectResult(false);
+    }
+    common::NetworkErrorEvent error_event;
+    error_event.message = std::string{error_msg};
+    error_event.connection_id = connection_id;
     common::EventBus::getInstance().publish(error_event);
     disconnect();
 }
 
 void AsioNetworkModel::processMessage(const std::vector<std::uint8_t>& message_data) {
     try {
+        // 按采样比例决定是否追踪这条消息, 追踪id随消息进入消息队列
+        auto& tracer = common::Tracer::getInstance();
+        uint64_t trace_id = tracer.sample();
+        tracer.record("socket_read", trace_id, read_start_ns_, common::Tracer::now());
+        common::TraceScope trace_scope(trace_id);
         std::string message{reinterpret_cast<const char*>(message_data.data()), message_data.size()};
-        if (auto msg = protocol::MessageFactory::parseMessage(message)) {
-            message_queue_.push(std::move(msg));
+        std::unique_ptr<protocol::IMessage> msg;
+        {
+            X30_TRACE_SPAN("frame_decode");
+            msg = protocol::MessageFactory::parseMessage(message);
+        }
+        if (msg) {
+            auto type = msg->getType();
+            X30_PROBE2(frame_decoded, static_cast<int>(type), message_data.size());
+            notifyMessageReceived(type);
+            msg->setTraceTag({trace_id, trace_id != 0 ? common::Tracer::now() : 0});
+            X30_TRACE_SPAN("queue_push");
+            // 遥测被丢弃属于预期的降级, 只有任务响应被拒绝时告警
+            if (!message_queue_.push(std::move(msg)) &&
+                common::MessageQueue::classify(type) != common::MessagePriority::TELEMETRY) {
+                spdlog::warn("[{}]: [AsioNetworkModel:WRN]: 消息队列超出预算, 丢弃消息 {}",
+                             common::getCurrentTimestamp(), static_cast<int>(type));
+            }
         }
         else {
             handleError(fmt::format("消息解析失败"));
@@ -130,21 +356,43 @@ void AsioNetworkModel::processMessage(const std::vector<std::uint8_t>& message_d
 }
 
 void AsioNetworkModel::doWrite() {
-    if (write_queue_.empty()) {
+    std::lock_guard<std::mutex> lock(write_queue_mutex_);
+    if (write_in_progress_ || !connected_) {
         return;
     }
+    // 上次未写完的消息优先重发, 否则取优先级最高的消息
+    if (in_flight_.empty()) {
+        if (!write_queue_.pop(in_flight_, in_flight_trace_id_, in_flight_type_)) {
+            return;
+        }
+        in_flight_popped_ns_ = in_flight_trace_id_ != 0 ? common::Tracer::now() : 0;
+    }
 
+    write_in_progress_ = true;
     boost::asio::async_write(
-        socket_, boost::asio::buffer(write_queue_.front()),
+        socket_, boost::asio::buffer(in_flight_),
         boost::asio::bind_executor(
             strand_, [this, self = shared_from_this()](const boost::system::error_code& error,
                                                        std::size_t /*bytes_transferred*/) { handleWrite(error); }));
 }
 
 void AsioNetworkModel::handleWrite(const boost::system::error_code& error) {
-    if (!error) {
+    protocol::MessageType written_type;
+    {
         std::lock_guard<std::mutex> lock(write_queue_mutex_);
-        write_queue_.pop();
+        write_in_progress_ = false;
+        written_type = in_flight_type_;
+        if (!error) {
+            recordFrame(CaptureDirection::OUTBOUND, in_flight_.data(), in_flight_.size());
+            common::Tracer::getInstance().record("socket_write", in_flight_trace_id_, in_flight_popped_ns_,
+                                                 common::Tracer::now());
+            in_flight_.clear();
+        }
+    }
+
+    if (!error) {
+        // 以整帧写完的时刻作为发送时间, 不含在发送队列和断线期间的等待
+        notifyMessageSent(written_type);
         doWrite();
     }
     else {
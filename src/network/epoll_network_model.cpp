@@ -2,6 +2,7 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <netdb.h>
 #include <netinet/in.h>
 #include <string.h>
 #include <sys/socket.h>
@@ -10,6 +11,9 @@
 #include <vector>
 #include "common/event_bus.hpp"
 #include "common/message_queue.hpp"
+#include "common/probes.hpp"
+#include "common/thread_config.hpp"
+#include "common/trace.hpp"
 #include "protocol/protocol_header.hpp"
 // #include <fmt/core.h>
 #include <spdlog/spdlog.h>
@@ -19,17 +23,35 @@ namespace network {
 
 static const int MAX_EVENTS = 10;
 static const ssize_t MAX_BUFFER_SIZE = 4096;
+// 相邻两个地址发起连接的间隔(RFC 8305 Connection Attempt Delay)
+static constexpr std::chrono::milliseconds CONNECT_ATTEMPT_DELAY{250};
+// 整个连接过程的超时时间
+static constexpr std::chrono::milliseconds CONNECT_TIMEOUT{5000};
+
+namespace {
+std::string formatEndpoint(const sockaddr_storage& addr) {
+    char buf[INET6_ADDRSTRLEN] = {0};
+    if (addr.ss_family == AF_INET6) {
+        inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6&>(addr).sin6_addr, buf, sizeof(buf));
+        return fmt::format("[{}]", buf);
+    }
+    inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in&>(addr).sin_addr, buf, sizeof(buf));
+    return buf;
+}
+}  // namespace
 
 EpollNetworkModel::EpollNetworkModel(common::MessageQueue& message_queue)
-    : running_(false), message_queue_(message_queue), epoll_fd_(-1), socket_fd_(-1), connected_(false) {
+    : running_(false),
+      message_queue_(message_queue),
+      epoll_fd_(-1),
+      socket_fd_(-1),
+      connected_(false),
+      connecting_(false),
+      write_offset_(0) {
 }
 
 EpollNetworkModel::~EpollNetworkModel() {
     disconnect();
-    running_ = false;
-    if (event_thread_.joinable()) {
-        event_thread_.join();
-    }
 }
 
 void EpollNetworkModel::setNonBlocking(int fd) {
@@ -42,72 +64,228 @@ bool EpollNetworkModel::initEpoll() {
     if (epoll_fd_ == -1) {
         return false;
     }
+    // 停止信号水平触发, disconnect时epoll_wait立即返回
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = stop_.fd();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_.fd(), &ev) == -1) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+        return false;
+    }
     return true;
 }
 
-bool EpollNetworkModel::connect(const std::string& host, uint16_t port) {
-    if (connected_) {
-        return false;
+std::vector<EpollNetworkModel::Endpoint> EpollNetworkModel::resolveEndpoints(const std::string& host,
+                                                                            uint16_t port) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG;
+
+    struct addrinfo* result = nullptr;
+    int rc = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result);
+    if (rc != 0) {
+        spdlog::error("[{}]: [EpollNetworkModel:ERR]: 地址解析失败: {}, {}", common::getCurrentTimestamp(), host,
+                      gai_strerror(rc));
+        return {};
     }
 
-    socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (socket_fd_ == -1) {
-        handleError(fmt::format("Failed to create socket"));
-        return false;
+    // 保持getaddrinfo给出的优先顺序, 在两个地址族之间交替(RFC 8305)
+    std::vector<Endpoint> primary;
+    std::vector<Endpoint> secondary;
+    for (auto* ai = result; ai != nullptr; ai = ai->ai_next) {
+        Endpoint endpoint;
+        memset(&endpoint.addr, 0, sizeof(endpoint.addr));
+        memcpy(&endpoint.addr, ai->ai_addr, ai->ai_addrlen);
+        endpoint.len = ai->ai_addrlen;
+        if (primary.empty() || primary.front().addr.ss_family == ai->ai_family) {
+            primary.push_back(endpoint);
+        }
+        else {
+            secondary.push_back(endpoint);
+        }
     }
+    freeaddrinfo(result);
 
-    setNonBlocking(socket_fd_);
+    std::vector<Endpoint> endpoints;
+    for (size_t i = 0; i < std::max(primary.size(), secondary.size()); ++i) {
+        if (i < primary.size()) {
+            endpoints.push_back(primary[i]);
+        }
+        if (i < secondary.size()) {
+            endpoints.push_back(secondary[i]);
+        }
+    }
+    return endpoints;
+}
 
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    if (inet_pton(AF_INET, host.c_str(), &server_addr.sin_addr) <= 0) {
-        close(socket_fd_);
-        handleError(fmt::format("Invalid address"));
+bool EpollNetworkModel::connect(const std::string& host, uint16_t port) {
+    if (connected_ || connecting_) {
         return false;
     }
+    beginConnection();
 
-    if (::connect(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) == -1) {
-        if (errno != EINPROGRESS) {
-            close(socket_fd_);
-            handleError(fmt::format("Connect failed"));
-            return false;
-        }
+    // 回收上一次连接遗留的事件线程(重连场景)
+    running_ = false;
+    stop_.requestStop();
+    if (event_thread_.joinable()) {
+        event_thread_.join();
     }
+    stop_.reset();
 
-    if (!initEpoll()) {
-        close(socket_fd_);
-        handleError(fmt::format("Failed to init epoll"));
+    auto endpoints = resolveEndpoints(host, port);
+    if (endpoints.empty()) {
         return false;
     }
 
-    struct epoll_event ev;
-    memset(&ev, 0, sizeof(ev));
-    ev.events = EPOLLIN | EPOLLET;
-    ev.data.fd = socket_fd_;
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_fd_, &ev) == -1) {
-        close(socket_fd_);
-        close(epoll_fd_);
-        handleError(fmt::format("Failed to add socket to epoll"));
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (!initEpoll()) {
+            spdlog::error("[{}]: [EpollNetworkModel:ERR]: Failed to init epoll", common::getCurrentTimestamp());
+            return false;
+        }
     }
 
-    connected_ = true;
+    // 各地址错开发起非阻塞连接, 由事件线程选出最先完成握手的连接
+    pending_endpoints_ = std::move(endpoints);
+    std::reverse(pending_endpoints_.begin(), pending_endpoints_.end());
+    connect_deadline_ = std::chrono::steady_clock::now() + CONNECT_TIMEOUT;
+    connecting_ = true;
+    startNextAttempt();
+
     // 启动事件循环线程
     running_ = true;
     event_thread_ = std::thread(&EpollNetworkModel::eventLoop, this);
     return true;
 }
 
-void EpollNetworkModel::disconnect() {
-    if (!connected_) {
+void EpollNetworkModel::startNextAttempt() {
+    while (!pending_endpoints_.empty()) {
+        Endpoint endpoint = pending_endpoints_.back();
+        pending_endpoints_.pop_back();
+
+        int fd = socket(endpoint.addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            spdlog::warn("[{}]: [EpollNetworkModel:WRN]: Failed to create socket for {}",
+                         common::getCurrentTimestamp(), formatEndpoint(endpoint.addr));
+            continue;
+        }
+        setNonBlocking(fd);
+
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&endpoint.addr), endpoint.len) == -1 &&
+            errno != EINPROGRESS) {
+            spdlog::warn("[{}]: [EpollNetworkModel:WRN]: 连接{}失败: {}", common::getCurrentTimestamp(),
+                         formatEndpoint(endpoint.addr), strerror(errno));
+            close(fd);
+            continue;
+        }
+
+        // 连接完成(成功或失败)时socket变为可写
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLOUT;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            close(fd);
+            continue;
+        }
+
+        attempt_fds_.push_back(fd);
+        next_attempt_at_ = std::chrono::steady_clock::now() + CONNECT_ATTEMPT_DELAY;
+        return;
+    }
+}
+
+void EpollNetworkModel::handleConnectEvent(int fd) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1) {
+        error = errno;
+    }
+
+    if (error == 0) {
+        if (!adoptSocket(fd)) {
+            handleError(fmt::format("Failed to add socket to epoll"));
+        }
+        return;
+    }
+
+    // 该地址失败, 立即尝试下一个地址
+    spdlog::warn("[{}]: [EpollNetworkModel:WRN]: 连接尝试失败: {}", common::getCurrentTimestamp(), strerror(error));
+    attempt_fds_.erase(std::remove(attempt_fds_.begin(), attempt_fds_.end(), fd), attempt_fds_.end());
+    close(fd);
+    startNextAttempt();
+}
+
+bool EpollNetworkModel::adoptSocket(int fd) {
+    attempt_fds_.erase(std::remove(attempt_fds_.begin(), attempt_fds_.end(), fd), attempt_fds_.end());
+    closeAttempts();
+    pending_endpoints_.clear();
+
+    sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    memset(&peer, 0, sizeof(peer));
+    getpeername(fd, reinterpret_cast<sockaddr*>(&peer), &peer_len);
+
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        socket_fd_ = fd;
+        // 断线期间积压的消息在连接建立后继续发送
+        if (!updateEpollEvents(!in_flight_.empty() || !write_queue_.empty())) {
+            return false;
+        }
+        connected_ = true;
+        connecting_ = false;
+    }
+
+    spdlog::info("[{}]: [EpollNetworkModel:INFO]: 已连接到 {}", common::getCurrentTimestamp(), formatEndpoint(peer));
+    notifyConnectResult(true);
+    return true;
+}
+
+void EpollNetworkModel::closeAttempts() {
+    for (int fd : attempt_fds_) {
+        close(fd);
+    }
+    attempt_fds_.clear();
+}
+
+void EpollNetworkModel::checkConnectProgress() {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= connect_deadline_) {
+        handleError(fmt::format("连接超时"));
         return;
     }
+    // 当前尝试迟迟没有结果, 并行发起下一个地址的连接
+    if (!pending_endpoints_.empty() && (attempt_fds_.empty() || now >= next_attempt_at_)) {
+        startNextAttempt();
+    }
+    if (attempt_fds_.empty() && pending_endpoints_.empty()) {
+        handleError(fmt::format("连接失败: 所有地址均不可达"));
+    }
+}
 
+void EpollNetworkModel::disconnect() {
     running_ = false;
     connected_ = false;
+    connecting_ = false;
+    stop_.requestStop();
+
+    // 事件线程自身出错时由handleError关闭连接, 不能在本线程中join
+    if (event_thread_.joinable() && event_thread_.get_id() != std::this_thread::get_id()) {
+        event_thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    closeSocket();
+}
 
+void EpollNetworkModel::closeSocket() {
+    closeAttempts();
+    pending_endpoints_.clear();
     if (socket_fd_ != -1) {
         close(socket_fd_);
         socket_fd_ = -1;
@@ -116,50 +294,78 @@ void EpollNetworkModel::disconnect() {
         close(epoll_fd_);
         epoll_fd_ = -1;
     }
-
-    handleError(fmt::format("网络连接失败"));
+    // 未写完的消息重连后需要从头重发
+    write_offset_ = 0;
 }
 
 void EpollNetworkModel::eventLoop() {
+    common::setupThread("x30-epoll");
     while (running_) {
         poll();
     }
 }
 
 void EpollNetworkModel::poll() {
-    if (!connected_) {
+    if (!connected_ && !connecting_) {
         return;
     }
 
+    // 已连接时只等待socket和停止信号; 连接中等到下一个地址的发起时间或连接超时
+    int timeout_ms = -1;
+    if (connecting_) {
+        auto wake_at = pending_endpoints_.empty() ? connect_deadline_ : std::min(next_attempt_at_, connect_deadline_);
+        auto until_next = std::chrono::ceil<std::chrono::milliseconds>(wake_at - std::chrono::steady_clock::now());
+        timeout_ms = std::max(static_cast<int>(until_next.count()), 0);
+    }
+
     struct epoll_event events[MAX_EVENTS];
-    int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, 100);
+    int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout_ms);
 
     if (nfds == -1) {
         if (errno != EINTR) {
-            disconnect();
+            handleError(fmt::format("epoll_wait失败: {}", strerror(errno)));
         }
         return;
     }
 
     for (int i = 0; i < nfds; ++i) {
+        if (events[i].data.fd == stop_.fd()) {
+            return;  // running_已清除, 事件循环随即退出
+        }
+        if (connecting_) {
+            handleConnectEvent(events[i].data.fd);
+            if (!connecting_) {
+                break;  // 已选出连接或已失败, 本轮其余事件属于已关闭的连接尝试
+            }
+            continue;
+        }
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            handleError(fmt::format("网络连接失败"));
+            return;
+        }
         if (events[i].events & EPOLLIN) {
             if (!handleRead()) {
-                disconnect();
+                handleError(fmt::format("网络连接失败"));
                 return;
             }
         }
         if (events[i].events & EPOLLOUT) {
             if (!handleWrite()) {
-                disconnect();
+                handleError(fmt::format("网络连接失败"));
                 return;
             }
         }
     }
+
+    if (connecting_) {
+        checkConnectProgress();
+    }
 }
 
 bool EpollNetworkModel::handleRead() {
     while (true) {
         // 接收并验证协议头
+        int64_t read_start_ns = common::Tracer::now();
         protocol::ProtocolHeader header;
         ssize_t n = read(socket_fd_, &header, sizeof(header));
         if (n > 0) {
@@ -184,13 +390,38 @@ bool EpollNetworkModel::handleRead() {
                         }
                     }
 
+                    recordFrame(CaptureDirection::INBOUND, &header, sizeof(header), buffer.data(), buffer.size());
+                    X30_PROBE1(frame_received, body_size);
+
+                    // 按采样比例决定是否追踪这条消息, 追踪id随消息进入消息队列
+                    auto& tracer = common::Tracer::getInstance();
+                    uint64_t trace_id = tracer.sample();
+                    tracer.record("socket_read", trace_id, read_start_ns, common::Tracer::now());
+                    common::TraceScope trace_scope(trace_id);
+
                     // 处理消息
                     std::string message(buffer.begin(), buffer.begin() + bytes_read);
-                    if (auto msg = protocol::MessageFactory::parseMessage(message)) {
-                        message_queue_.push(std::move(msg));
+                    std::unique_ptr<protocol::IMessage> msg;
+                    {
+                        X30_TRACE_SPAN("frame_decode");
+                        msg = protocol::MessageFactory::parseMessage(message);
+                    }
+                    if (msg) {
+                        auto type = msg->getType();
+                        X30_PROBE2(frame_decoded, static_cast<int>(type), body_size);
+                        notifyMessageReceived(type);
+                        msg->setTraceTag({trace_id, trace_id != 0 ? common::Tracer::now() : 0});
+                        X30_TRACE_SPAN("queue_push");
+                        // 遥测被丢弃属于预期的降级, 只有任务响应被拒绝时告警
+                        if (!message_queue_.push(std::move(msg)) &&
+                            common::MessageQueue::classify(type) != common::MessagePriority::TELEMETRY) {
+                            spdlog::warn("[{}]: [EpollNetworkModel:WRN]: 消息队列超出预算, 丢弃消息 {}",
+                                         common::getCurrentTimestamp(), static_cast<int>(type));
+                        }
                     }
                     else {
-                        handleError(fmt::format("Message parse failed"));
+                        spdlog::error("[{}]: [EpollNetworkModel:ERR]: Message parse failed",
+                                      common::getCurrentTimestamp());
                         return false;  // 消息解析失败
                     }
                 }
@@ -210,11 +441,19 @@ bool EpollNetworkModel::handleRead() {
 
 bool EpollNetworkModel::handleWrite() {
     std::lock_guard<std::mutex> lock(write_mutex_);
-    while (!write_queue_.empty()) {
-        const std::string& data = write_queue_.front();
-        ssize_t n = write(socket_fd_, data.c_str(), data.size());
+    while (!in_flight_.empty() || popInFlight()) {
+        ssize_t n = write(socket_fd_, in_flight_.data() + write_offset_, in_flight_.size() - write_offset_);
         if (n > 0) {
-            write_queue_.pop();
+            write_offset_ += static_cast<size_t>(n);
+            if (write_offset_ == in_flight_.size()) {
+                recordFrame(CaptureDirection::OUTBOUND, in_flight_.data(), in_flight_.size());
+                common::Tracer::getInstance().record("socket_write", in_flight_trace_id_, in_flight_popped_ns_,
+                                                     common::Tracer::now());
+                // 以整帧写入内核的时刻作为发送时间, 不含在发送队列和断线期间的等待
+                notifyMessageSent(in_flight_type_);
+                in_flight_.clear();
+                write_offset_ = 0;
+            }
         }
         else if (n == -1) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
@@ -224,48 +463,70 @@ bool EpollNetworkModel::handleWrite() {
         }
     }
 
-    struct epoll_event ev;
-    memset(&ev, 0, sizeof(ev));
-    ev.events = EPOLLIN | EPOLLET;
-    ev.data.fd = socket_fd_;
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket_fd_, &ev) == -1) {
+    return updateEpollEvents(false);
+}
+
+bool EpollNetworkModel::popInFlight() {
+    if (!write_queue_.pop(in_flight_, in_flight_trace_id_, in_flight_type_)) {
         return false;
     }
+    in_flight_popped_ns_ = in_flight_trace_id_ != 0 ? common::Tracer::now() : 0;
     return true;
 }
 
+bool EpollNetworkModel::updateEpollEvents(bool want_write) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = want_write ? (EPOLLIN | EPOLLOUT | EPOLLET) : (EPOLLIN | EPOLLET);
+    ev.data.fd = socket_fd_;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket_fd_, &ev) != -1;
+}
+
 bool EpollNetworkModel::isConnected() const {
     return connected_;
 }
 
-void EpollNetworkModel::sendMessage(const protocol::IMessage& message) {
-    if (!connected_) {
-        return;
-    }
-
-    // 序列化消息并加入发送队列
+SendResult EpollNetworkModel::sendMessage(const protocol::IMessage& message) {
+    // 序列化消息并加入发送队列, 未连接时保留在队列中等待重连
     std::string serialized_message = message.serialize();
+    SendResult result;
     {
         std::lock_guard<std::mutex> lock(write_mutex_);
-        write_queue_.push(std::move(serialized_message));
+        result = write_queue_.push(message.getType(), std::move(serialized_message), common::Tracer::currentTraceId());
+        if (result != SendResult::REJECTED && connected_ && !updateEpollEvents(true)) {
+            spdlog::error("[{}]: [EpollNetworkModel:ERR]: Failed to modify socket epoll events",
+                          common::getCurrentTimestamp());
+        }
     }
 
-    struct epoll_event ev;
-    memset(&ev, 0, sizeof(ev));
-    ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
-    ev.data.fd = socket_fd_;
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket_fd_, &ev) == -1) {
-        close(socket_fd_);
-        close(epoll_fd_);
-        handleError(fmt::format("Failed to add socket to epoll"));
-        return;
+    if (result == SendResult::REJECTED) {
+        spdlog::warn("[{}]: [EpollNetworkModel:WRN]: 发送队列已满, 丢弃消息: {}", common::getCurrentTimestamp(),
+                     static_cast<int>(message.getType()));
     }
+    return result;
 }
 
 void EpollNetworkModel::handleError(std::string_view error_msg) {
-    spdlog::error("[{}]: 网络错误: {}, 请检查网络连接, 程序需要重新启动", common::getCurrentTimestamp(), error_msg);
-    auto error_event = std::make_shared<common::NetworkErrorEvent>();
-    error_event->message = std::string{error_msg};
+    // 只有第一次出错时关闭连接并通知, 避免重复触发重连
+    // 编号在判断状态之前读取: 通过判断说明出错时尚未断开, 新连接的connect还未递增编号
+    uint64_t connection_id = connectionId();
+    bool was_connecting = connecting_.exchange(false);
+    if (!connected_.exchange(false) && !was_connecting) {
+        return;
+    }
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        closeSocket();
+    }
+
+    spdlog::error("[{}]: 网络错误: {}, 连接已断开", common::getCurrentTimestamp(), error_msg);
+    if (was_connecting) {
+        notifyConnectResult(false);
+    }
+    common::NetworkErrorEvent error_event;
+    error_event.message = std::string{error_msg};
+    error_event.connection_id = connection_id;
     common::EventBus::getInstance().publish(error_event);
 }
 
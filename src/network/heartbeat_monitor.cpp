@@ -0,0 +1,151 @@
+#include "network/heartbeat_monitor.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include "common/utils.hpp"
+
+namespace network {
+
+namespace {
+// RFC 6298 推荐参数
+constexpr double RTT_ALPHA = 0.125;
+constexpr double RTT_BETA = 0.25;
+constexpr double CLOCK_GRANULARITY_MS = 1.0;
+// 检测周期
+constexpr std::chrono::milliseconds TICK_INTERVAL{100};
+}  // namespace
+
+HeartbeatMonitor::HeartbeatMonitor(HeartbeatPolicy policy, ProbeSender probe_sender, DeadHandler dead_handler)
+    : policy_(policy), probe_sender_(std::move(probe_sender)), dead_handler_(std::move(dead_handler)) {
+}
+
+HeartbeatMonitor::~HeartbeatMonitor() {
+    stop();
+}
+
+void HeartbeatMonitor::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tick_timer_ != 0) {
+        return;
+    }
+    tick_timer_ = common::TimerWheel::getInstance().schedulePeriodic(TICK_INTERVAL, [this]() { tick(); });
+}
+
+void HeartbeatMonitor::stop() {
+    common::TimerWheel::TimerId timer = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(timer, tick_timer_);
+    }
+    // tick中会加mutex_, 取消时不能持有, 否则与正在执行的tick互相等待
+    common::TimerWheel::getInstance().cancel(timer);
+}
+
+void HeartbeatMonitor::onConnected() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    link_up_ = true;
+    srtt_ = -1.0;
+    rttvar_ = 0.0;
+    outstanding_probes_ = 0;
+    last_probe_at_ = std::chrono::steady_clock::now();
+}
+
+void HeartbeatMonitor::onDisconnected() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    link_up_ = false;
+    outstanding_probes_ = 0;
+}
+
+void HeartbeatMonitor::onMessageSent(protocol::MessageType type) {
+    if (type != protocol::MessageType::QUERY_STATUS_REQ) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    if (outstanding_probes_ == 0) {
+        probe_sent_at_ = now;
+    }
+    ++outstanding_probes_;
+    last_probe_at_ = now;
+}
+
+void HeartbeatMonitor::onMessageReceived(protocol::MessageType type) {
+    if (type != protocol::MessageType::QUERY_STATUS_RESP) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (outstanding_probes_ == 0) {
+        return;
+    }
+    // Karn算法: 多个探测同时未响应时无法确定响应对应哪个请求, 不采样
+    if (outstanding_probes_ == 1) {
+        std::chrono::duration<double, std::milli> sample = std::chrono::steady_clock::now() - probe_sent_at_;
+        updateRtt(sample.count());
+    }
+    outstanding_probes_ = 0;
+}
+
+void HeartbeatMonitor::updateRtt(double sample_ms) {
+    if (srtt_ < 0) {
+        srtt_ = sample_ms;
+        rttvar_ = sample_ms / 2;
+    }
+    else {
+        rttvar_ = (1 - RTT_BETA) * rttvar_ + RTT_BETA * std::abs(srtt_ - sample_ms);
+        srtt_ = (1 - RTT_ALPHA) * srtt_ + RTT_ALPHA * sample_ms;
+    }
+}
+
+double HeartbeatMonitor::srtt() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return srtt_;
+}
+
+double HeartbeatMonitor::rttvar() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rttvar_;
+}
+
+std::chrono::milliseconds HeartbeatMonitor::timeout() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timeoutLocked();
+}
+
+std::chrono::milliseconds HeartbeatMonitor::timeoutLocked() const {
+    if (srtt_ < 0) {
+        return policy_.initial_timeout;
+    }
+    double rto = srtt_ + std::max(CLOCK_GRANULARITY_MS, 4 * rttvar_);
+    auto timeout = std::chrono::milliseconds(static_cast<int64_t>(rto * policy_.rto_multiplier));
+    return std::clamp(timeout, policy_.min_timeout, policy_.max_timeout);
+}
+
+void HeartbeatMonitor::tick() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!link_up_) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (outstanding_probes_ > 0) {
+        auto timeout = timeoutLocked();
+        if (now - probe_sent_at_ > timeout) {
+            // 判定失效后暂停检测, 等待重连后的onConnected
+            link_up_ = false;
+            outstanding_probes_ = 0;
+            std::string reason = fmt::format("心跳超时: {}ms内未收到2007响应, srtt={:.1f}ms, rttvar={:.1f}ms",
+                                             timeout.count(), srtt_, rttvar_);
+            lock.unlock();
+            dead_handler_(reason);
+        }
+    }
+    else if (now - last_probe_at_ >= policy_.probe_interval) {
+        // 空闲时没有定时1007, 主动发送探测
+        lock.unlock();
+        probe_sender_();
+    }
+}
+
+}  // namespace network
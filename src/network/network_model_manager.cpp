@@ -1,13 +1,43 @@
 #include "network/network_model_manager.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include "common/event_bus.hpp"
+#include "common/metrics.hpp"
+#include "common/thread_config.hpp"
 #include "common/utils.hpp"
 #include "network/base_network_model.hpp"
 namespace network {
 
+namespace {
+// 等待连接结果的兜底超时, 正常情况下网络模型会在自身的连接超时后通知失败
+constexpr std::chrono::milliseconds CONNECT_WAIT_TIMEOUT{10000};
+
+struct LinkMetrics {
+    common::Counter& link_lost;
+    common::Counter& reconnect_attempts;
+    common::Counter& reconnected;
+};
+
+LinkMetrics& linkMetrics() {
+    auto& registry = common::MetricsRegistry::getInstance();
+    static LinkMetrics metrics{registry.counter("x30_link_lost_total", "链路断开次数, 含心跳超时"),
+                               registry.counter("x30_reconnect_attempts_total", "重连尝试次数"),
+                               registry.counter("x30_reconnects_total", "重连成功次数")};
+    return metrics;
+}
+}  // namespace
+
 // NetworkModelManager实现
-NetworkModelManager::NetworkModelManager(network::NetworkModelType model_type, common::MessageQueue& message_queue)
-    : model_type_(model_type), message_queue_(message_queue) {
+NetworkModelManager::NetworkModelManager(network::NetworkModelType model_type, common::MessageQueue& message_queue,
+                                         ReconnectPolicy policy, HeartbeatPolicy heartbeat_policy)
+    : model_type_(model_type),
+      message_queue_(message_queue),
+      policy_(policy),
+      heartbeat_monitor_(std::make_shared<HeartbeatMonitor>(
+          heartbeat_policy, [this]() { sendProbe(); },
+          [this](const std::string& reason) { onHeartbeatTimeout(reason); })) {
 }
 
 NetworkModelManager::~NetworkModelManager() {
@@ -17,8 +47,37 @@ NetworkModelManager::~NetworkModelManager() {
 bool NetworkModelManager::start(const std::string& host, uint16_t port) {
     try {
         network_model_ = network::NetworkModelFactory::createNetworkModel(model_type_, message_queue_);
+        network_model_->setLinkObserver(heartbeat_monitor_);
+        network_model_->setConnectCallback([this](bool connected) { onConnectResult(connected); });
+        network_model_->setTrafficRecorder(traffic_recorder_);
+        host_ = host;
+        port_ = port;
+        {
+            std::lock_guard<std::mutex> lock(reconnect_mutex_);
+            stopping_ = false;
+        }
+
+        // 订阅网络错误事件, 由重连线程负责恢复连接
+        error_handler_id_ = common::EventBus::getInstance().subscribe<common::NetworkErrorEvent>(
+            [this](const common::NetworkErrorEvent& event) { onLinkLost(event.connection_id); });
+
+        // 首次连接失败直接报告, 不进入重连
+        if (!connectAndWait()) {
+            spdlog::error("[{}]: [NetworkModelManager:ERR]: 连接{}:{}失败", common::getCurrentTimestamp(), host, port);
+            stop();
+            return false;
+        }
 
-        return network_model_->connect(host, port);
+        {
+            std::lock_guard<std::mutex> lock(reconnect_mutex_);
+            link_lost_ = false;
+            connected_at_ = std::chrono::steady_clock::now();
+        }
+        reconnect_thread_ = std::thread(&NetworkModelManager::reconnectLoop, this);
+
+        heartbeat_monitor_->onConnected();
+        heartbeat_monitor_->start();
+        return true;
     }
     catch (const std::exception& e) {
         spdlog::error("[{}]: [NetworkModelManager]: 启动失败, 错误: {}", common::getCurrentTimestamp(), e.what());
@@ -27,12 +86,194 @@ bool NetworkModelManager::start(const std::string& host, uint16_t port) {
     }
 }
 
+bool NetworkModelManager::connectAndWait() {
+    std::future<bool> result;
+    {
+        std::lock_guard<std::mutex> lock(connect_mutex_);
+        {
+            // stop()先置位stopping_再兑现promise, 此处检查避免在stop之后再次等待
+            std::lock_guard<std::mutex> stop_lock(reconnect_mutex_);
+            if (stopping_) {
+                return false;
+            }
+        }
+        connect_promise_ = std::promise<bool>();
+        result = connect_promise_->get_future();
+    }
+
+    if (!network_model_->connect(host_, port_)) {
+        std::lock_guard<std::mutex> lock(connect_mutex_);
+        connect_promise_.reset();
+        return false;
+    }
+
+    // 连接完成回调或stop()都会兑现promise, 超时仅作为兜底
+    if (result.wait_for(CONNECT_WAIT_TIMEOUT) != std::future_status::ready) {
+        {
+            std::lock_guard<std::mutex> lock(connect_mutex_);
+            connect_promise_.reset();
+        }
+        network_model_->disconnect();
+        return false;
+    }
+    return result.get();
+}
+
+void NetworkModelManager::onConnectResult(bool connected) {
+    std::lock_guard<std::mutex> lock(connect_mutex_);
+    if (connect_promise_) {
+        connect_promise_->set_value(connected);
+        connect_promise_.reset();
+    }
+}
+
 void NetworkModelManager::stop() {
-    network_model_->disconnect();
+    heartbeat_monitor_->stop();
+    {
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        stopping_ = true;
+    }
+    reconnect_cv_.notify_all();
+    // 唤醒正在等待连接结果的重连线程
+    onConnectResult(false);
+    if (reconnect_thread_.joinable()) {
+        reconnect_thread_.join();
+    }
+    if (error_handler_id_ != common::EventBus::INVALID_HANDLER_ID) {
+        common::EventBus::getInstance().unsubscribe(error_handler_id_);
+        error_handler_id_ = common::EventBus::INVALID_HANDLER_ID;
+    }
+
+    if (network_model_) {
+        network_model_->disconnect();
+    }
 }
 
 std::shared_ptr<BaseNetworkModel> NetworkModelManager::getNetworkModel() {
     return network_model_;
 }
 
+void NetworkModelManager::setTrafficRecorder(std::shared_ptr<TrafficRecorder> recorder) {
+    traffic_recorder_ = std::move(recorder);
+}
+
+void NetworkModelManager::onLinkLost(uint64_t connection_id, const std::string& heartbeat_reason) {
+    {
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        if (stopping_) {
+            return;
+        }
+        // 同一连接的断线只处理一次(如心跳超时后重连线程发布的NetworkErrorEvent)
+        if (connection_id == lost_connection_id_) {
+            return;
+        }
+        // 重连线程清除link_lost_后, 被断开的旧连接或失败的连接尝试的错误可能迟到, 不能再触发一次重连
+        if (connection_id < network_model_->connectionId()) {
+            spdlog::info("[{}]: [NetworkModelManager:INFO]: 忽略过期的网络错误, 连接编号: {}",
+                         common::getCurrentTimestamp(), connection_id);
+            return;
+        }
+        lost_connection_id_ = connection_id;
+        link_lost_ = true;
+        heartbeat_loss_reason_ = heartbeat_reason;
+    }
+    linkMetrics().link_lost.inc();
+    heartbeat_monitor_->onDisconnected();
+    reconnect_cv_.notify_all();
+}
+
+void NetworkModelManager::sendProbe() {
+    protocol::QueryStatusRequest request;
+    request.timestamp = common::getCurrentTimestamp();
+    network_model_->sendMessage(request);
+}
+
+void NetworkModelManager::onHeartbeatTimeout(const std::string& reason) {
+    // 定时器线程中不能阻塞: 不在此join事件线程或同步分发事件, 由重连线程断开并重连
+    spdlog::error("[{}]: 网络错误: {}, 准备重连", common::getCurrentTimestamp(), reason);
+    onLinkLost(network_model_->connectionId(), reason);
+}
+
+std::chrono::milliseconds NetworkModelManager::nextDelay(int attempt) {
+    double delay = static_cast<double>(policy_.initial_delay.count()) * std::pow(policy_.multiplier, attempt);
+    delay = std::min(delay, static_cast<double>(policy_.max_delay.count()));
+    // 抖动避免多台设备在同一时刻集中重连
+    std::uniform_real_distribution<double> dist(1.0 - policy_.jitter, 1.0);
+    return std::chrono::milliseconds(static_cast<int64_t>(delay * dist(rng_)));
+}
+
+void NetworkModelManager::reconnectLoop() {
+    common::setupThread("x30-reconnect");
+    std::unique_lock<std::mutex> lock(reconnect_mutex_);
+    while (true) {
+        reconnect_cv_.wait(lock, [this] { return stopping_ || link_lost_; });
+        if (stopping_) {
+            return;
+        }
+
+        // 半开连接不会产生socket错误, 心跳判定失效时在此通知其他订阅者, 连接由下面的重连流程断开
+        if (!heartbeat_loss_reason_.empty()) {
+            common::NetworkErrorEvent error_event;
+            error_event.message = std::move(heartbeat_loss_reason_);
+            // 与onHeartbeatTimeout记录的是同一次断线, 订阅的onLinkLost不会重复计数
+            error_event.connection_id = lost_connection_id_;
+            heartbeat_loss_reason_.clear();
+            lock.unlock();
+            common::EventBus::getInstance().publish(error_event);
+            lock.lock();
+            if (stopping_) {
+                return;
+            }
+        }
+
+        // 连接稳定运行过一段时间, 退避从头开始
+        if (std::chrono::steady_clock::now() - connected_at_ >= policy_.stable_period) {
+            attempts_ = 0;
+        }
+
+        while (!stopping_) {
+            auto delay = nextDelay(attempts_);
+            spdlog::warn("[{}]: [NetworkModelManager:WRN]: {}ms后进行第{}次重连", common::getCurrentTimestamp(),
+                         delay.count(), attempts_ + 1);
+            if (reconnect_cv_.wait_for(lock, delay, [this] { return stopping_; })) {
+                return;
+            }
+
+            ++attempts_;
+            linkMetrics().reconnect_attempts.inc();
+            // 连接尝试期间产生的错误不应再次触发重连
+            link_lost_ = false;
+            lock.unlock();
+            network_model_->disconnect();
+            bool connected = connectAndWait();
+            lock.lock();
+
+            if (connected && !stopping_) {
+                linkMetrics().reconnected.inc();
+                heartbeat_monitor_->onConnected();
+                connected_at_ = std::chrono::steady_clock::now();
+                int attempts = attempts_;
+                lock.unlock();
+                spdlog::info("[{}]: [NetworkModelManager:INFO]: 第{}次重连成功", common::getCurrentTimestamp(),
+                             attempts);
+                common::NetworkReconnectedEvent event;
+                event.attempts = attempts;
+                common::EventBus::getInstance().publish(event);
+                lock.lock();
+                break;
+            }
+
+            if (policy_.max_attempts > 0 && attempts_ >= policy_.max_attempts) {
+                lock.unlock();
+                spdlog::error("[{}]: [NetworkModelManager:ERR]: 连续重连{}次失败, 放弃重连",
+                              common::getCurrentTimestamp(), policy_.max_attempts);
+                common::NetworkReconnectFailedEvent event;
+                event.message = fmt::format("连续重连{}次失败", policy_.max_attempts);
+                common::EventBus::getInstance().publish(event);
+                return;
+            }
+        }
+    }
+}
+
 }  // namespace network
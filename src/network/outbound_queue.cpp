@@ -0,0 +1,77 @@
+#include "network/outbound_queue.hpp"
+#include <algorithm>
+
+namespace network {
+
+OutboundQueue::OutboundQueue(size_t control_capacity, size_t mission_capacity, size_t telemetry_capacity)
+    : capacities_{control_capacity, mission_capacity, telemetry_capacity} {
+}
+
+SendPriority OutboundQueue::classify(protocol::MessageType type) {
+    switch (type) {
+        case protocol::MessageType::CANCEL_TASK_REQ:
+            return SendPriority::CONTROL;
+        case protocol::MessageType::NAVIGATION_TASK_REQ:
+            return SendPriority::MISSION;
+        case protocol::MessageType::GET_REAL_TIME_STATUS_REQ:
+        case protocol::MessageType::QUERY_STATUS_REQ:
+            return SendPriority::TELEMETRY;
+        default:
+            return SendPriority::MISSION;
+    }
+}
+
+SendResult OutboundQueue::push(protocol::MessageType type, std::string frame, uint64_t trace_id) {
+    auto priority = classify(type);
+    auto& lane = lanes_[static_cast<size_t>(priority)];
+
+    // 遥测轮询只关心最新结果, 用新请求替换尚未发送的旧请求
+    if (priority == SendPriority::TELEMETRY) {
+        auto it = std::find_if(lane.begin(), lane.end(), [type](const Entry& entry) { return entry.type == type; });
+        if (it != lane.end()) {
+            it->frame = std::move(frame);
+            it->trace_id = trace_id;
+            return SendResult::REPLACED;
+        }
+    }
+
+    if (lane.size() >= capacities_[static_cast<size_t>(priority)]) {
+        return SendResult::REJECTED;
+    }
+
+    lane.push_back(Entry{type, std::move(frame), trace_id});
+    return SendResult::QUEUED;
+}
+
+bool OutboundQueue::pop(std::string& frame) {
+    uint64_t trace_id = 0;
+    protocol::MessageType type;
+    return pop(frame, trace_id, type);
+}
+
+bool OutboundQueue::pop(std::string& frame, uint64_t& trace_id, protocol::MessageType& type) {
+    for (auto& lane : lanes_) {
+        if (!lane.empty()) {
+            frame = std::move(lane.front().frame);
+            trace_id = lane.front().trace_id;
+            type = lane.front().type;
+            lane.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OutboundQueue::empty() const {
+    return std::all_of(lanes_.begin(), lanes_.end(), [](const std::deque<Entry>& lane) { return lane.empty(); });
+}
+
+size_t OutboundQueue::size() const {
+    size_t total = 0;
+    for (const auto& lane : lanes_) {
+        total += lane.size();
+    }
+    return total;
+}
+
+}  // namespace network
@@ -0,0 +1,139 @@
+#include "network/traffic_recorder.hpp"
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "common/utils.hpp"
+
+namespace network {
+
+namespace {
+// 初始映射大小, 不足时按倍数扩展
+constexpr size_t INITIAL_CAPACITY = 16 * 1024 * 1024;
+}  // namespace
+
+constexpr char TrafficRecorder::MAGIC[8];
+
+TrafficRecorder::TrafficRecorder(std::string path) : path_(std::move(path)) {
+}
+
+TrafficRecorder::~TrafficRecorder() {
+    close();
+}
+
+bool TrafficRecorder::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        spdlog::error("[{}]: [TrafficRecorder:ERR]: 打开抓包文件失败: {}, {}", common::getCurrentTimestamp(), path_,
+                      strerror(errno));
+        return false;
+    }
+
+    offset_ = 0;
+    if (!ensureCapacity(INITIAL_CAPACITY)) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    CaptureFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.start_wall_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    memcpy(data_, &header, sizeof(header));
+    offset_ = sizeof(header);
+    start_ = std::chrono::steady_clock::now();
+
+    spdlog::info("[{}]: [TrafficRecorder:INFO]: 开始抓包: {}", common::getCurrentTimestamp(), path_);
+    return true;
+}
+
+void TrafficRecorder::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ == -1) {
+        return;
+    }
+
+    munmap(data_, capacity_);
+    // 截掉预留的空白部分
+    if (ftruncate(fd_, static_cast<off_t>(offset_)) == -1) {
+        spdlog::warn("[{}]: [TrafficRecorder:WRN]: 截断抓包文件失败: {}", common::getCurrentTimestamp(),
+                     strerror(errno));
+    }
+    ::close(fd_);
+    fd_ = -1;
+    data_ = nullptr;
+    capacity_ = 0;
+    spdlog::info("[{}]: [TrafficRecorder:INFO]: 抓包结束: {}, {} 字节", common::getCurrentTimestamp(), path_, offset_);
+}
+
+bool TrafficRecorder::isOpen() const {
+    return fd_ != -1;
+}
+
+void TrafficRecorder::record(CaptureDirection direction, const void* head, size_t head_size, const void* body,
+                             size_t body_size) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ == -1) {
+        return;
+    }
+
+    size_t frame_size = head_size + body_size;
+    // 额外预留一条记录头, 保证文件中总有一个length为0的结束标记
+    if (!ensureCapacity(offset_ + 2 * sizeof(CaptureRecordHeader) + frame_size)) {
+        return;
+    }
+
+    CaptureRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.timestamp_ns =
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count());
+    header.length = static_cast<uint32_t>(frame_size);
+    header.direction = static_cast<uint8_t>(direction);
+
+    uint8_t* dst = data_ + offset_;
+    memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+    memcpy(dst, head, head_size);
+    if (body_size > 0) {
+        memcpy(dst + head_size, body, body_size);
+    }
+    offset_ += sizeof(header) + frame_size;
+}
+
+bool TrafficRecorder::ensureCapacity(size_t required) {
+    if (required <= capacity_) {
+        return true;
+    }
+
+    size_t new_capacity = capacity_ == 0 ? INITIAL_CAPACITY : capacity_;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    if (ftruncate(fd_, static_cast<off_t>(new_capacity)) == -1) {
+        spdlog::error("[{}]: [TrafficRecorder:ERR]: 扩展抓包文件失败: {}", common::getCurrentTimestamp(),
+                      strerror(errno));
+        return false;
+    }
+
+    void* mapped = data_ == nullptr ? mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)
+                                    : mremap(data_, capacity_, new_capacity, MREMAP_MAYMOVE);
+    if (mapped == MAP_FAILED) {
+        spdlog::error("[{}]: [TrafficRecorder:ERR]: 映射抓包文件失败: {}", common::getCurrentTimestamp(),
+                      strerror(errno));
+        return false;
+    }
+
+    data_ = static_cast<uint8_t*>(mapped);
+    capacity_ = new_capacity;
+    return true;
+}
+
+}  // namespace network
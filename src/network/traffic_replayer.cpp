@@ -0,0 +1,113 @@
+#include "network/traffic_replayer.hpp"
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include "common/message_queue.hpp"
+#include "common/utils.hpp"
+#include "protocol/protocol_header.hpp"
+#include "protocol/x30_protocol.hpp"
+
+namespace network {
+
+TrafficReplayer::TrafficReplayer(std::string path) : path_(std::move(path)) {
+}
+
+TrafficReplayer::~TrafficReplayer() {
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+bool TrafficReplayer::open() {
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ == -1) {
+        spdlog::error("[{}]: [TrafficReplayer:ERR]: 打开抓包文件失败: {}, {}", common::getCurrentTimestamp(), path_,
+                      strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(CaptureFileHeader)) {
+        spdlog::error("[{}]: [TrafficReplayer:ERR]: 抓包文件无效: {}", common::getCurrentTimestamp(), path_);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        spdlog::error("[{}]: [TrafficReplayer:ERR]: 映射抓包文件失败: {}", common::getCurrentTimestamp(),
+                      strerror(errno));
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapped);
+
+    CaptureFileHeader file_header;
+    memcpy(&file_header, data_, sizeof(file_header));
+    if (memcmp(file_header.magic, TrafficRecorder::MAGIC, sizeof(file_header.magic)) != 0 ||
+        file_header.version != TrafficRecorder::VERSION) {
+        spdlog::error("[{}]: [TrafficReplayer:ERR]: 抓包文件格式不匹配: {}", common::getCurrentTimestamp(), path_);
+        return false;
+    }
+
+    // 进程异常退出时文件尾部可能是未截断的空白或不完整记录, 遇到即停止
+    size_t offset = sizeof(CaptureFileHeader);
+    while (offset + sizeof(CaptureRecordHeader) <= size_) {
+        CaptureRecordHeader record;
+        memcpy(&record, data_ + offset, sizeof(record));
+        offset += sizeof(record);
+        if (record.length == 0 || offset + record.length > size_) {
+            break;
+        }
+        frames_.push_back(CapturedFrame{record.timestamp_ns, static_cast<CaptureDirection>(record.direction),
+                                        std::string_view(reinterpret_cast<const char*>(data_ + offset),
+                                                         record.length)});
+        offset += record.length;
+    }
+
+    spdlog::info("[{}]: [TrafficReplayer:INFO]: 加载抓包文件: {}, {} 帧", common::getCurrentTimestamp(), path_,
+                 frames_.size());
+    return true;
+}
+
+const std::vector<CapturedFrame>& TrafficReplayer::frames() const {
+    return frames_;
+}
+
+ReplayStats TrafficReplayer::replay(common::MessageQueue& message_queue, double speed) const {
+    ReplayStats stats;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& frame : frames_) {
+        if (frame.direction != CaptureDirection::INBOUND || frame.data.size() < sizeof(protocol::ProtocolHeader)) {
+            continue;
+        }
+
+        if (speed > 0) {
+            auto offset = std::chrono::nanoseconds(static_cast<int64_t>(frame.timestamp_ns / speed));
+            std::this_thread::sleep_until(start + offset);
+        }
+
+        // 与网络模型相同的处理路径: 去掉协议头, 解析消息体后入队
+        std::string body(frame.data.substr(sizeof(protocol::ProtocolHeader)));
+        if (auto msg = protocol::MessageFactory::parseMessage(body)) {
+            message_queue.push(std::move(msg));
+        }
+        else {
+            ++stats.parse_failures;
+        }
+        ++stats.frames;
+        stats.bytes += frame.data.size();
+    }
+    stats.elapsed_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+}  // namespace network
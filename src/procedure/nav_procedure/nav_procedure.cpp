@@ -2,6 +2,10 @@
 #include <iostream>
 #include <memory>
 #include "common/event_bus.hpp"
+#include "common/log_sampler.hpp"
+#include "common/metrics.hpp"
+#include "common/timer_wheel.hpp"
+#include "common/trace.hpp"
 #include "common/utils.hpp"
 #include "state/nav/nav_context.hpp"
 #include "state/nav/nav_machine.hpp"
@@ -14,7 +18,10 @@ NavigationProcedure::NavigationProcedure(state::NavigationContext context) {
     state_machine_ = std::make_unique<state::NavigationMachine>(std::move(context));
 
     // 设置状态机终止回调
-    state_machine_->set_terminate_callback([this]() { stopStatusQuery(); });
+    state_machine_->set_terminate_callback([this]() {
+        finished_ = true;
+        stopStatusQuery();
+    });
 }
 
 NavigationProcedure::~NavigationProcedure() {
@@ -28,15 +35,21 @@ void NavigationProcedure::start() {
 }
 
 void NavigationProcedure::process_event(const protocol::IMessage& message) {
+    static auto& duration = common::MetricsRegistry::getInstance().histogram(
+        "x30_nav_process_event_duration_ns", "导航流程处理一条消息(含状态机转移)的耗时, 纳秒");
+    common::ScopedTimer timer(duration);
+    X30_TRACE_SPAN("process_event");
     // TODO: 如果交互协议多，可以使用EventBus进行消息分发
     switch (message.getType()) {
         case protocol::MessageType::NAVIGATION_TASK_RESP: {
             auto& resp = dynamic_cast<const protocol::NavigationTaskResponse&>(message);
+            X30_TRACE_SPAN("msm_transition");
             state_machine_->process_event(resp);
             break;
         }
         case protocol::MessageType::CANCEL_TASK_RESP: {
             auto& resp = dynamic_cast<const protocol::CancelTaskResponse&>(message);
+            X30_TRACE_SPAN("msm_transition");
             state_machine_->process_event(resp);
             break;
         }
@@ -44,41 +57,44 @@ void NavigationProcedure::process_event(const protocol::IMessage& message) {
             auto& resp = dynamic_cast<const protocol::QueryStatusResponse&>(message);
             // auto event = common::QueryStatusEvent::fromResponse(resp);
             // common::EventBus::getInstance().publish(event);
+            X30_TRACE_SPAN("msm_transition");
             state_machine_->process_event(resp);
             break;
         }
         default: {
-            spdlog::warn("[{}]: [NavProc:WRN]: 无法处理当前消息类型", common::getCurrentTimestamp());
+            X30_LOG_SAMPLED("NavProc:未知消息", 1.0, 5, spdlog::level::warn, "[{}]: [NavProc:WRN]: 无法处理当前消息类型",
+                            common::getCurrentTimestamp());
             // std::cout << fmt::format("[{}]: [NavProc:WRN]: 无法处理当前消息类型", common::getCurrentTimestamp()) << std::endl;
             break;
         }
     }
 }
 
-void NavigationProcedure::statusQueryLoop() {
-    while (status_query_running_) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(STATUS_QUERY_INTERVAL_MS));
-        protocol::QueryStatusRequest request;
-        request.timestamp = common::getCurrentTimestamp();
-        state_machine_->context_.network_model->sendMessage(request);
-        // std::cout << fmt::format("[{}]: [NavProc:INFO]: 定时发送1007 Request", request.timestamp) << std::endl;
-    }
+void NavigationProcedure::sendStatusQuery() {
+    static auto& queries = common::MetricsRegistry::getInstance().counter("x30_nav_status_queries_total",
+                                                                          "导航过程中定时发送的1007状态查询数");
+    // 定时查询没有入站消息可继承追踪id, 在此独立采样
+    common::TraceScope trace_scope(common::Tracer::getInstance().sample());
+    X30_TRACE_SPAN("status_query");
+    protocol::QueryStatusRequest request;
+    request.timestamp = common::getCurrentTimestamp();
+    state_machine_->context_.network_model->sendMessage(request);
+    queries.inc();
+    // std::cout << fmt::format("[{}]: [NavProc:INFO]: 定时发送1007 Request", request.timestamp) << std::endl;
 }
 
 void NavigationProcedure::startStatusQuery() {
-    if (status_query_running_) {
+    if (status_query_timer_ != 0) {
         return;
     }
 
-    status_query_running_ = true;
-    status_query_thread_ = std::thread(&NavigationProcedure::statusQueryLoop, this);
+    status_query_timer_ = common::TimerWheel::getInstance().schedulePeriodic(STATUS_QUERY_INTERVAL,
+                                                                             [this]() { sendStatusQuery(); });
 }
 
 void NavigationProcedure::stopStatusQuery() {
-    status_query_running_ = false;
-    if (status_query_thread_.joinable()) {
-        status_query_thread_.join();
-    }
+    // 立即生效: 返回后不会再发送1007, 也不再引用本对象
+    common::TimerWheel::getInstance().cancel(status_query_timer_.exchange(0));
 }
 
 }  // namespace procedure
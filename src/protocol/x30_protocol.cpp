@@ -3,6 +3,9 @@
 #include <ctime>
 #include <iostream>
 #include <sstream>
+#include "common/metrics.hpp"
+#include "common/probes.hpp"
+#include "common/trace.hpp"
 #include "common/utils.hpp"
 #include "protocol/protocol_header.hpp"
 
@@ -14,6 +17,8 @@ namespace protocol {
 
 // IMessage实现
 std::string IMessage::serialize() const {
+    X30_TRACE_SPAN("serialize");
+    X30_PROBE1(serialize_begin, static_cast<int>(getType()));
     std::string xml_data = serializeToXml();
     ProtocolHeader header(xml_data.size());
 
@@ -21,6 +26,7 @@ std::string IMessage::serialize() const {
     result.reserve(HEADER_SIZE + xml_data.size());
     result.append(reinterpret_cast<const char*>(&header), HEADER_SIZE);
     result.append(xml_data);
+    X30_PROBE2(serialize_end, static_cast<int>(getType()), result.size());
     return result;
 }
 
@@ -480,17 +486,21 @@ std::unique_ptr<IMessage> MessageFactory::createResponseMessage(MessageType type
 }
 
 std::unique_ptr<IMessage> MessageFactory::parseMessage(const std::string& xml) {
+    static auto& registry = common::MetricsRegistry::getInstance();
+    static auto& parse_duration = registry.histogram("x30_message_parse_duration_ns", "消息体解析耗时, 纳秒");
+    static auto& parse_failures = registry.counter("x30_message_parse_failures_total", "消息体解析失败次数");
+    common::ScopedTimer timer(parse_duration);
+
     rapidxml::xml_document<> doc;
     try {
         doc.parse<rapidxml::parse_non_destructive>(const_cast<char*>(xml.c_str()));
 
         auto root = doc.first_node("PatrolDevice");
-        if (!root)
-            return nullptr;
-
-        auto typeNode = root->first_node("Type");
-        if (!typeNode)
+        auto typeNode = root ? root->first_node("Type") : nullptr;
+        if (!typeNode) {
+            parse_failures.inc();
             return nullptr;
+        }
         auto message = createMessage(static_cast<MessageType>(std::stoi(typeNode->value()) + 1000));
         if (message && message->deserialize(xml)) {
             return message;
@@ -499,6 +509,7 @@ std::unique_ptr<IMessage> MessageFactory::parseMessage(const std::string& xml) {
     catch (const std::exception& e) {
         std::cerr << "Failed to parse message: " << e.what() << std::endl;
     }
+    parse_failures.inc();
     return nullptr;
 }
 
@@ -11,7 +11,10 @@ void SendNavRequest::execute(state::NavigationContext& context) {
     protocol::NavigationTaskRequest req;
     req.points = points;
     req.timestamp = common::getCurrentTimestamp();
-    context.network_model->sendMessage(req);
+    if (context.network_model->sendMessage(req) == network::SendResult::REJECTED) {
+        spdlog::error("[{}]: [NavFsm:Action]: 发送1003 Request失败, 发送队列已满", req.timestamp);
+        return;
+    }
     spdlog::info("[{}]: [NavFsm:Action]: 发送1003 Request, 导航点数量: {}", req.timestamp, points.size());
     // std::cout << fmt::format("[{}]: [NavFsm:Action]: 发送1003 Request, 导航点数量: {}", req.timestamp, points.size()) << std::endl;
 }
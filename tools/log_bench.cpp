@@ -0,0 +1,121 @@
+// 日志调用延迟压测工具
+// 对比同步sink与AsyncLogSink(DROP_NEWEST / BLOCK)下, 调用线程一次spdlog::info的耗时分布
+// 下游为文件sink加一个可配置耗时的慢sink, 用来模拟慢终端或慢磁盘
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/async_log_sink.hpp"
+#include "common/utils.hpp"
+
+namespace {
+
+// 每条日志耗时delay的sink
+class SlowSink : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    explicit SlowSink(std::chrono::microseconds delay) : delay_(delay) {}
+
+protected:
+    void sink_it_(const spdlog::details::log_msg&) override {
+        if (delay_.count() > 0) {
+            std::this_thread::sleep_for(delay_);
+        }
+    }
+    void flush_() override {}
+
+private:
+    std::chrono::microseconds delay_;
+};
+
+enum class Mode { SYNC, ASYNC_DROP, ASYNC_BLOCK };
+
+const char* modeName(Mode mode) {
+    switch (mode) {
+        case Mode::SYNC:
+            return "SYNC";
+        case Mode::ASYNC_DROP:
+            return "ASYNC_DROP";
+        case Mode::ASYNC_BLOCK:
+            return "ASYNC_BLOCK";
+    }
+    return "UNKNOWN";
+}
+
+struct BenchResult {
+    double elapsed_ms = 0.0;  // 调用线程耗时, 不含最后的flush
+    double total_ms = 0.0;    // 含flush, 即全部写出的耗时
+    int64_t p50_ns = 0;
+    int64_t p99_ns = 0;
+    int64_t p999_ns = 0;
+    int64_t max_ns = 0;
+    uint64_t dropped = 0;
+};
+
+BenchResult runBench(Mode mode, size_t messages, std::chrono::microseconds delay, const std::string& log_path) {
+    std::vector<spdlog::sink_ptr> sinks{std::make_shared<spdlog::sinks::basic_file_sink_mt>(log_path, true),
+                                        std::make_shared<SlowSink>(delay)};
+    std::shared_ptr<common::AsyncLogSink> async_sink;
+    if (mode != Mode::SYNC) {
+        async_sink = std::make_shared<common::AsyncLogSink>(std::move(sinks), 8192,
+                                                            mode == Mode::ASYNC_DROP
+                                                                ? common::AsyncLogOverflowPolicy::DROP_NEWEST
+                                                                : common::AsyncLogOverflowPolicy::BLOCK);
+        sinks = {async_sink};
+    }
+    auto logger = std::make_shared<spdlog::logger>("bench", sinks.begin(), sinks.end());
+    logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] [%t] %v");
+
+    std::vector<int64_t> samples;
+    samples.reserve(messages);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < messages; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        logger->info("[{}]: 当前位置坐标: [{:.5f}, {:.5f}, {:.5f}]，累计里程数：{:.2f}, 机器人定位状态: {}", i, 1.0 * i,
+                     2.0 * i, 0.5, 100.0 + i, 0);
+        samples.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    logger->flush();
+    auto total = std::chrono::steady_clock::now() - start;
+
+    std::sort(samples.begin(), samples.end());
+    BenchResult result;
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    result.total_ms = std::chrono::duration<double, std::milli>(total).count();
+    result.p50_ns = samples[samples.size() / 2];
+    result.p99_ns = samples[samples.size() * 99 / 100];
+    result.p999_ns = samples[samples.size() * 999 / 1000];
+    result.max_ns = samples.back();
+    result.dropped = async_sink ? async_sink->dropped() : 0;
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 4) {
+        spdlog::error("[{}]: 用法: {} [messages] [slow_sink_us] [log_file]", common::getCurrentTimestamp(), argv[0]);
+        return 1;
+    }
+    size_t messages = argc > 1 ? std::stoul(argv[1]) : 100000;
+    auto delay = std::chrono::microseconds(argc > 2 ? std::stol(argv[2]) : 0);
+    std::string log_path = argc > 3 ? argv[3] : "/tmp/x30_log_bench.log";
+
+    spdlog::info("[{}]: 日志压测: 每轮 {} 条, 慢sink每条 {} us, 输出文件 {}", common::getCurrentTimestamp(), messages,
+                 delay.count(), log_path);
+    for (Mode mode : {Mode::SYNC, Mode::ASYNC_DROP, Mode::ASYNC_BLOCK}) {
+        BenchResult result = runBench(mode, messages, delay, log_path);
+        spdlog::info(
+            "[{}]: {:<11} 调用耗时 {:.1f} ms, 全部写出 {:.1f} ms, 单次调用 p50 {} ns, p99 {} ns, p99.9 {} ns, max {} ns, "
+            "丢弃 {}",
+            common::getCurrentTimestamp(), modeName(mode), result.elapsed_ms, result.total_ms, result.p50_ns,
+            result.p99_ns, result.p999_ns, result.max_ns, result.dropped);
+    }
+    return 0;
+}
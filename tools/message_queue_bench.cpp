@@ -0,0 +1,115 @@
+// MessageQueue竞争压测工具
+// 多个生产者线程并发push, 单个消费者线程pop, 对比LOCKED与LOCK_FREE两种实现的吞吐和push延迟
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/message_queue.hpp"
+#include "common/utils.hpp"
+#include "protocol/x30_protocol.hpp"
+
+namespace {
+
+struct BenchResult {
+    double elapsed_ms = 0.0;
+    double push_p50_ns = 0.0;
+    double push_p99_ns = 0.0;
+};
+
+// 每隔SAMPLE_INTERVAL次push采样一次耗时, 避免计时本身影响结果
+constexpr size_t SAMPLE_INTERVAL = 64;
+
+BenchResult runBench(common::MessageQueueType type, int producers, size_t messages_per_producer, size_t capacity) {
+    common::MessageQueueOptions options;
+    options.type = type;
+    options.capacity = capacity;
+    common::MessageQueue message_queue(options);
+
+    // 预先分配消息, 只测量队列本身
+    std::vector<std::vector<std::unique_ptr<protocol::IMessage>>> messages(producers);
+    for (auto& batch : messages) {
+        batch.reserve(messages_per_producer);
+        for (size_t i = 0; i < messages_per_producer; ++i) {
+            batch.push_back(std::make_unique<protocol::ProcedureReset>());
+        }
+    }
+
+    std::atomic<bool> go{false};
+    std::vector<std::vector<int64_t>> samples(producers);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            samples[p].reserve(messages_per_producer / SAMPLE_INTERVAL + 1);
+            while (!go.load(std::memory_order_acquire)) {
+            }
+            for (size_t i = 0; i < messages_per_producer; ++i) {
+                if (i % SAMPLE_INTERVAL == 0) {
+                    auto begin = std::chrono::steady_clock::now();
+                    message_queue.push(std::move(messages[p][i]));
+                    samples[p].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now() - begin)
+                                             .count());
+                }
+                else {
+                    message_queue.push(std::move(messages[p][i]));
+                }
+            }
+        });
+    }
+
+    size_t total = messages_per_producer * static_cast<size_t>(producers);
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (size_t received = 0; received < total; ++received) {
+        message_queue.pop();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int64_t> all;
+    for (auto& s : samples) {
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    BenchResult result;
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    if (!all.empty()) {
+        result.push_p50_ns = static_cast<double>(all[all.size() / 2]);
+        result.push_p99_ns = static_cast<double>(all[all.size() * 99 / 100]);
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 4) {
+        spdlog::error("[{}]: 用法: {} [max_producers] [messages_per_producer] [capacity]",
+                      common::getCurrentTimestamp(), argv[0]);
+        return 1;
+    }
+    int max_producers = argc >= 2 ? std::stoi(argv[1]) : 4;
+    size_t messages_per_producer = argc >= 3 ? std::stoul(argv[2]) : 200000;
+    size_t capacity = argc >= 4 ? std::stoul(argv[3]) : common::MessageQueueOptions{}.capacity;
+
+    const std::pair<common::MessageQueueType, const char*> types[] = {
+        {common::MessageQueueType::LOCKED, "LOCKED"},
+        {common::MessageQueueType::LOCK_FREE, "LOCK_FREE"},
+    };
+    for (int producers = 1; producers <= max_producers; producers *= 2) {
+        for (const auto& [type, name] : types) {
+            auto result = runBench(type, producers, messages_per_producer, capacity);
+            double total = static_cast<double>(messages_per_producer) * producers;
+            spdlog::info("[{}]: {:>9} 生产者 {}: {:.0f} 条/秒, push p50 {:.0f} ns, p99 {:.0f} ns",
+                         common::getCurrentTimestamp(), name, producers, total / (result.elapsed_ms / 1000.0),
+                         result.push_p50_ns, result.push_p99_ns);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+// TimerWheel校验与压测工具
+// 先校验第0层按tick触发、跨层(第1层下放到第0层)的长延时定时器、下放后再取消、周期定时器不漂移,
+// 再批量添加定时器统计触发延迟; 任一校验失败时返回1
+// 第2层覆盖655秒以上, 默认不校验, 传入long_delay_seconds(>655)时额外校验一次第2层下放
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/timer_wheel.hpp"
+#include "common/utils.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+// 触发时间允许的误差: 添加时当前tick向下取整, 最多早一个tick; 线程唤醒和调度再留出余量
+constexpr milliseconds EARLY_TOLERANCE = common::TimerWheel::TICK;
+constexpr milliseconds LATE_TOLERANCE = common::TimerWheel::TICK + milliseconds(30);
+
+int failures = 0;
+
+void check(bool ok, const std::string& name, const std::string& detail) {
+    if (ok) {
+        spdlog::info("[{}]: [PASS] {}: {}", common::getCurrentTimestamp(), name, detail);
+    }
+    else {
+        spdlog::error("[{}]: [FAIL] {}: {}", common::getCurrentTimestamp(), name, detail);
+        ++failures;
+    }
+}
+
+// 单次定时器的触发时间
+struct Firing {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool fired = false;
+    Clock::time_point at;
+
+    void fire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        fired = true;
+        at = Clock::now();
+        cv.notify_all();
+    }
+
+    bool wait(milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, timeout, [this] { return fired; });
+    }
+};
+
+// 校验一个单次定时器在delay附近触发
+void checkDelay(const std::string& name, milliseconds delay) {
+    auto& wheel = common::TimerWheel::getInstance();
+    Firing firing;
+    auto start = Clock::now();
+    wheel.schedule(delay, [&firing]() { firing.fire(); });
+    if (!firing.wait(delay + LATE_TOLERANCE + milliseconds(1000))) {
+        check(false, name, fmt::format("{}ms定时器未触发", delay.count()));
+        return;
+    }
+    auto actual = std::chrono::duration_cast<milliseconds>(firing.at - start);
+    check(actual >= delay - EARLY_TOLERANCE && actual <= delay + LATE_TOLERANCE, name,
+          fmt::format("延时 {}ms, 实际 {}ms", delay.count(), actual.count()));
+}
+
+// 长延时定时器先放在上层, 下放到第0层之后再取消, 之后不应触发
+void checkCancelAfterCascade() {
+    auto& wheel = common::TimerWheel::getInstance();
+    auto span = common::TimerWheel::TICK * common::TimerWheel::SLOTS;  // 第0层覆盖范围, 2.56s
+    std::atomic<bool> fired{false};
+    auto id = wheel.schedule(span + milliseconds(1000), [&fired]() { fired = true; });
+    // 等第0层转满一圈, 定时器已从第1层下放, 距到期还有约1秒
+    std::this_thread::sleep_for(span + milliseconds(200));
+    bool cancelled = wheel.cancel(id);
+    std::this_thread::sleep_for(milliseconds(1000) + LATE_TOLERANCE);
+    check(cancelled && !fired, "下放后取消",
+          fmt::format("cancel返回 {}, 回调{}执行", cancelled, fired ? "已" : "未"));
+    check(!wheel.cancel(id), "重复取消", "已取消的定时器再次取消返回false");
+}
+
+// 周期定时器按计划时间触发, 次数不因回调耗时漂移
+void checkPeriodic() {
+    auto& wheel = common::TimerWheel::getInstance();
+    constexpr milliseconds interval{100};
+    constexpr int expected = 20;
+    std::atomic<int> count{0};
+    auto start = Clock::now();
+    auto id = wheel.schedulePeriodic(interval, [&count]() {
+        count.fetch_add(1);
+        // 模拟回调耗时, 不应推迟之后的触发
+        std::this_thread::sleep_for(milliseconds(15));
+    });
+    std::this_thread::sleep_until(start + interval * expected + interval / 2);
+    wheel.cancel(id);
+    int fired = count.load();
+    check(fired >= expected - 1 && fired <= expected + 1, "周期定时器",
+          fmt::format("{}ms周期运行{}ms, 触发 {} 次, 期望 {} 次", interval.count(),
+                      (interval * expected + interval / 2).count(), fired, expected));
+}
+
+// 批量添加随机延时的定时器, 统计相对计划时间的触发延迟
+// 延时取tick的整数倍, 避免schedule按tick向下取整带来的额外提前量
+void benchLateness(size_t timers, milliseconds max_delay) {
+    auto& wheel = common::TimerWheel::getInstance();
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> dist(1, max_delay / common::TimerWheel::TICK);
+
+    std::mutex mutex;
+    std::vector<int64_t> lateness_us;
+    lateness_us.reserve(timers);
+    std::atomic<size_t> fired{0};
+
+    auto schedule_begin = Clock::now();
+    for (size_t i = 0; i < timers; ++i) {
+        milliseconds delay = common::TimerWheel::TICK * dist(rng);
+        auto due = Clock::now() + delay;
+        wheel.schedule(delay, [&, due]() {
+            auto late = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - due).count();
+            std::lock_guard<std::mutex> lock(mutex);
+            lateness_us.push_back(late);
+            fired.fetch_add(1, std::memory_order_release);
+        });
+    }
+    double schedule_ns = std::chrono::duration<double, std::nano>(Clock::now() - schedule_begin).count() /
+                         static_cast<double>(timers);
+
+    auto deadline = Clock::now() + max_delay + LATE_TOLERANCE + milliseconds(1000);
+    while (fired.load(std::memory_order_acquire) < timers && Clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    check(lateness_us.size() == timers, "批量触发", fmt::format("{} / {} 个定时器已触发", lateness_us.size(), timers));
+    if (lateness_us.empty()) {
+        return;
+    }
+    std::sort(lateness_us.begin(), lateness_us.end());
+    int64_t max_late_us = lateness_us.back();
+    spdlog::info("[{}]: 批量 {} 个定时器(0~{}ms): schedule {:.0f} ns/次, 触发延迟 p50 {} us, p99 {} us, max {} us",
+                 common::getCurrentTimestamp(), timers, max_delay.count(), schedule_ns,
+                 lateness_us[lateness_us.size() / 2], lateness_us[lateness_us.size() * 99 / 100], max_late_us);
+    check(lateness_us.front() >= -std::chrono::duration_cast<std::chrono::microseconds>(EARLY_TOLERANCE).count() &&
+              max_late_us <= std::chrono::duration_cast<std::chrono::microseconds>(LATE_TOLERANCE).count(),
+          "批量触发误差", fmt::format("最早 {} us, 最晚 {} us", lateness_us.front(), max_late_us));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 3) {
+        spdlog::error("[{}]: 用法: {} [timers] [long_delay_seconds]", common::getCurrentTimestamp(), argv[0]);
+        return 1;
+    }
+    size_t timers = argc >= 2 ? std::stoul(argv[1]) : 10000;
+    int64_t long_delay_seconds = argc >= 3 ? std::stol(argv[2]) : 0;
+
+    auto span = common::TimerWheel::TICK * common::TimerWheel::SLOTS;
+    checkDelay("第0层", milliseconds(50));
+    checkDelay("第0层末格", span - common::TimerWheel::TICK);
+    checkDelay("第1层下放", span + milliseconds(440));
+    checkCancelAfterCascade();
+    checkPeriodic();
+    benchLateness(timers, milliseconds(4000));
+    if (long_delay_seconds > 0) {
+        checkDelay("长延时", std::chrono::seconds(long_delay_seconds));
+    }
+
+    common::TimerWheel::getInstance().shutdown();
+    if (failures > 0) {
+        spdlog::error("[{}]: {} 项校验失败", common::getCurrentTimestamp(), failures);
+        return 1;
+    }
+    spdlog::info("[{}]: 全部校验通过", common::getCurrentTimestamp());
+    return 0;
+}
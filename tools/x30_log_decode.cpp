@@ -0,0 +1,211 @@
+// 二进制日志解码工具
+// 读取BinaryLogger写出的文件, 按格式定义将每条记录还原为文本, 输出到标准输出
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+#include <string.h>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/binary_log.hpp"
+#include "common/utils.hpp"
+
+namespace {
+
+struct FormatInfo {
+    spdlog::level::level_enum level = spdlog::level::info;
+    int line = 0;
+    std::string signature;
+    std::string file;
+    std::string format;
+};
+
+// 按顺序读取记录内容的游标, 越界时置failed
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T read() {
+        T value{};
+        if (!ensure(sizeof(T))) {
+            return value;
+        }
+        memcpy(&value, data_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return value;
+    }
+
+    std::string readString(size_t length) {
+        if (!ensure(length)) {
+            return {};
+        }
+        std::string value(reinterpret_cast<const char*>(data_ + offset_), length);
+        offset_ += length;
+        return value;
+    }
+
+    bool failed() const {
+        return failed_;
+    }
+
+private:
+    bool ensure(size_t size) {
+        if (failed_ || offset_ + size > size_) {
+            failed_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_ = 0;
+    bool failed_ = false;
+};
+
+// 按参数类型读取一个参数, 并用占位符中的格式说明格式化
+std::string formatArg(Reader& reader, char code, const std::string& spec) {
+    auto pattern = "{" + spec + "}";
+    switch (code) {
+        case 'i':
+            return fmt::format(fmt::runtime(pattern), reader.read<int32_t>());
+        case 'l':
+            return fmt::format(fmt::runtime(pattern), reader.read<int64_t>());
+        case 'u':
+            return fmt::format(fmt::runtime(pattern), reader.read<uint32_t>());
+        case 'U':
+            return fmt::format(fmt::runtime(pattern), reader.read<uint64_t>());
+        case 'd':
+            return fmt::format(fmt::runtime(pattern), reader.read<double>());
+        case 'b':
+            return fmt::format(fmt::runtime(pattern), reader.read<uint8_t>() != 0);
+        case 's': {
+            auto length = reader.read<uint16_t>();
+            return fmt::format(fmt::runtime(pattern), reader.readString(length));
+        }
+        default:
+            return "<?>";
+    }
+}
+
+// 逐个替换格式串中的占位符; 只支持顺序占位符, {{ 和 }} 为转义
+std::string render(const FormatInfo& info, Reader& reader) {
+    std::string text;
+    size_t arg_index = 0;
+    const std::string& format = info.format;
+    for (size_t i = 0; i < format.size(); ++i) {
+        char c = format[i];
+        if (c == '{' && i + 1 < format.size() && format[i + 1] == '{') {
+            text += '{';
+            ++i;
+        }
+        else if (c == '}' && i + 1 < format.size() && format[i + 1] == '}') {
+            text += '}';
+            ++i;
+        }
+        else if (c == '{') {
+            size_t end = format.find('}', i);
+            if (end == std::string::npos || arg_index >= info.signature.size()) {
+                text += format.substr(i);
+                break;
+            }
+            std::string spec = format.substr(i + 1, end - i - 1);
+            try {
+                text += formatArg(reader, info.signature[arg_index], spec);
+            }
+            catch (const std::exception&) {
+                text += "<格式错误>";
+            }
+            ++arg_index;
+            i = end;
+        }
+        else {
+            text += c;
+        }
+    }
+    return text;
+}
+
+std::string wallTime(uint64_t wall_ns) {
+    time_t seconds = static_cast<time_t>(wall_ns / 1000000000ULL);
+    std::tm tm{};
+    localtime_r(&seconds, &tm);
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+    return fmt::format("{}.{:06d}", buffer, static_cast<int>((wall_ns % 1000000000ULL) / 1000));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        spdlog::error("[{}]: 用法: {} <binary_log_file>", common::getCurrentTimestamp(), argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        spdlog::error("[{}]: 打开文件失败: {}", common::getCurrentTimestamp(), argv[1]);
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    common::BinaryLogFileHeader header;
+    if (data.size() < sizeof(header)) {
+        spdlog::error("[{}]: 文件过短: {}", common::getCurrentTimestamp(), argv[1]);
+        return 1;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, common::BinaryLogger::MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != common::BinaryLogger::VERSION) {
+        spdlog::error("[{}]: 不是二进制日志文件或版本不支持: {}", common::getCurrentTimestamp(), argv[1]);
+        return 1;
+    }
+
+    std::unordered_map<uint16_t, FormatInfo> formats;
+    size_t offset = sizeof(header);
+    size_t entries = 0;
+    while (offset + sizeof(common::BinaryLogRecordHeader) <= data.size()) {
+        common::BinaryLogRecordHeader record;
+        memcpy(&record, data.data() + offset, sizeof(record));
+        offset += sizeof(record);
+        auto type = static_cast<common::BinaryLogRecordType>(record.type);
+        if (type == common::BinaryLogRecordType::END || offset + record.length > data.size()) {
+            break;
+        }
+        Reader reader(data.data() + offset, record.length);
+        offset += record.length;
+
+        if (type == common::BinaryLogRecordType::FORMAT) {
+            FormatInfo info;
+            info.level = static_cast<spdlog::level::level_enum>(reader.read<uint8_t>());
+            info.line = reader.read<int32_t>();
+            info.signature = reader.readString(reader.read<uint8_t>());
+            info.file = reader.readString(reader.read<uint16_t>());
+            info.format = reader.readString(reader.read<uint16_t>());
+            formats[record.format_id] = std::move(info);
+            continue;
+        }
+
+        auto it = formats.find(record.format_id);
+        if (it == formats.end()) {
+            std::cout << "[未知调用点 " << record.format_id << "]\n";
+            continue;
+        }
+        std::string text = render(it->second, reader);
+        auto level = spdlog::level::to_string_view(it->second.level);
+        std::cout << "[" << wallTime(header.start_wall_ns + record.timestamp_ns) << "] ["
+                  << std::string(level.data(), level.size()) << "] " << text << "\n";
+        ++entries;
+    }
+
+    // 统计信息输出到标准错误, 便于将解码结果重定向到文件
+    std::cerr << fmt::format("[{}]: 解码完成: {} 条日志, {} 个调用点, 文件 {} 字节", common::getCurrentTimestamp(),
+                             entries, formats.size(), data.size())
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,62 @@
+// 抓包回放工具
+// 将抓包文件中的入站帧按原速、倍速或最快速度送入MessageFactory和MessageQueue,
+// 消费线程取出消息并计数, 用于复现现场问题以及对解码和队列路径做可重复的压测
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/message_queue.hpp"
+#include "common/utils.hpp"
+#include "network/traffic_replayer.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        spdlog::error("[{}]: 用法: {} <capture_file> [speed] [repeat]  (speed: 1原速, N倍速, 0最快)",
+                      common::getCurrentTimestamp(), argv[0]);
+        return 1;
+    }
+
+    network::TrafficReplayer replayer(argv[1]);
+    if (!replayer.open()) {
+        return 1;
+    }
+    double speed = argc >= 3 ? std::stod(argv[2]) : 1.0;
+    // 抓包较小时可重复回放多轮, 使压测结果稳定
+    int repeat = argc == 4 ? std::stoi(argv[3]) : 1;
+
+    common::MessageQueue message_queue;
+    size_t consumed = 0;
+    std::chrono::steady_clock::time_point last_consumed;
+    std::thread consumer([&]() {
+        // 与消息处理线程相同, 每次唤醒批量取出
+        std::vector<std::unique_ptr<protocol::IMessage>> batch;
+        while (message_queue.drain(batch, 64) > 0) {
+            consumed += batch.size();
+            batch.clear();
+            last_consumed = std::chrono::steady_clock::now();
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    network::ReplayStats stats;
+    for (int i = 0; i < repeat; ++i) {
+        auto round = replayer.replay(message_queue, speed);
+        stats.frames += round.frames;
+        stats.bytes += round.bytes;
+        stats.parse_failures += round.parse_failures;
+        stats.elapsed_ms += round.elapsed_ms;
+    }
+    message_queue.close();
+    consumer.join();
+
+    double total_ms =
+        consumed > 0 ? std::chrono::duration<double, std::milli>(last_consumed - start).count() : stats.elapsed_ms;
+    double seconds = total_ms / 1000.0;
+    spdlog::info("[{}]: 回放完成: {} 帧, {} 字节, 解析失败 {} 帧, 消费 {} 条", common::getCurrentTimestamp(),
+                 stats.frames, stats.bytes, stats.parse_failures, consumed);
+    spdlog::info("[{}]: 耗时 {:.3f} ms, 吞吐 {:.0f} 帧/秒, {:.2f} MB/秒", common::getCurrentTimestamp(), total_ms,
+                 seconds > 0 ? stats.frames / seconds : 0.0,
+                 seconds > 0 ? stats.bytes / seconds / (1024.0 * 1024.0) : 0.0);
+    return 0;
+}